@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include "batch.h"
+
+/*
+Benchmark of the batch scheduler on a mixed corpus. Every job is a countdown loop, and the loop counts cycle through
+powers of ten, so job run times span five orders of magnitude as between task1/addpos and a scaled-up task3/loop.
+The corpus runs on 1, 2, 4, ... threads up to the number of online CPUs or the given maximum, and the speedup over
+one thread and the jobs stolen are reported. The programs and manifest are written to a temporary directory.
+
+Usage: benchBatch [jobs] [max threads] [engine] [time slice in instructions]
+*/
+
+#define DEFAULT_JOBS        (600)
+#define LOOP_DECADES        (6)     // Loop counts from 10 to 10^LOOP_DECADES
+#define LOOP_INSTRUCTS(n)   (2 * (uint64_t) (n) + 4)    // Instructions run by the loop of n iterations
+
+/*** Static function prototypes ***/
+static bool     writeLoop(const char* fileName, uint32_t iterations);
+static uint32_t iterationsOf(uint32_t decade);
+
+int main(int argc, char* argv[])
+{
+    uint32_t nJobs = (argc > 1) ? strtoul(argv[1], NULL, 0) : DEFAULT_JOBS;
+    uint32_t maxThreads = (argc > 2) ? strtoul(argv[2], NULL, 0) : (uint32_t) sysconf(_SC_NPROCESSORS_ONLN);
+    sim_engine_t engine = simEngineFromName((argc > 3) ? argv[3] : NULL);
+    batch_options_t options = { .engine = engine, .memSize = GUEST_MEM_DEFAULT_BYTES, .format = FILEUTILS_FORMAT_RAW,
+                                .slice = (argc > 4) ? strtoull(argv[4], NULL, 0) : 0 };
+    char dirName[] = "/tmp/benchBatchXXXXXX";
+    char fileName[sizeof(dirName) + 32];
+    uint64_t instructCount = 0;
+    double seconds1 = 0.0;
+    bool retVal = true;
+    batch_t batch;
+    FILE* manifest;
+
+    if (nJobs == 0 || maxThreads == 0 || engine == SIM_ENGINE_UNKNOWN)
+    {
+        fprintf(stderr, "Usage: %s [jobs] [max threads] [engine] [time slice in instructions]\n", argv[0]);
+        return 1;
+    }
+    if (mkdtemp(dirName) == NULL)
+    {
+        perror("benchBatch error: Failed creating temporary directory");
+        return 1;
+    }
+
+    // One program per loop count, and jobs cycling through them so long jobs are spread over the manifest
+    snprintf(fileName, sizeof(fileName), "%s/jobs.txt", dirName);
+    manifest = fopen(fileName, "w");
+    for (uint32_t decade = 1; decade <= LOOP_DECADES && retVal; decade++)
+    {
+        snprintf(fileName, sizeof(fileName), "%s/loop%" PRIu32 ".bin", dirName, decade);
+        retVal = writeLoop(fileName, iterationsOf(decade - 1));
+    }
+    for (uint32_t job = 0; job < nJobs && manifest != NULL; job++)
+    {
+        fprintf(manifest, "%s/loop%" PRIu32 ".bin\n", dirName, job % LOOP_DECADES + 1);
+        instructCount += LOOP_INSTRUCTS(iterationsOf(job % LOOP_DECADES));
+    }
+    if (manifest == NULL || fclose(manifest) != 0 || !retVal)
+    {
+        fprintf(stderr, "benchBatch error: Failed writing the corpus to %s\n", dirName);
+        return 1;
+    }
+
+    snprintf(fileName, sizeof(fileName), "%s/jobs.txt", dirName);
+    if (!batchReadManifest(fileName, &batch))
+    {
+        return 1;
+    }
+    printf("%" PRIu32 " jobs of 10 to 10^%d loop iterations, %" PRIu64 " instructions, engine %s, slice %" PRIu64 "\n",
+           nJobs, LOOP_DECADES, instructCount, simEngineName(engine), options.slice);
+    for (uint32_t threads = 1; retVal; threads *= 2)
+    {
+        threads = (threads > maxThreads) ? maxThreads : threads;
+        options.threads = threads;
+        if ( (retVal = batchRun(&batch, &options)) )
+        {
+            seconds1 = (threads == 1) ? batch.seconds : seconds1;
+            printf("threads %3" PRIu32 ": %.3f s, %7.1f MIPS, speedup %5.2fx, efficiency %3.0f%%, %" PRIu64 " steals\n", batch.threads,
+                   batch.seconds, instructCount / batch.seconds * 1e-6, seconds1 / batch.seconds,
+                   100.0 * seconds1 / batch.seconds / batch.threads, batch.steals);
+            for (uint32_t i = 0; i < batch.count; i++)
+            {
+                retVal = retVal && batch.jobs[i].status == BATCH_PASS;
+            }
+        }
+        if (threads == maxThreads)
+        {
+            break;
+        }
+    }
+    batchFree(&batch);
+
+    for (uint32_t decade = 1; decade <= LOOP_DECADES; decade++)
+    {
+        snprintf(fileName, sizeof(fileName), "%s/loop%" PRIu32 ".bin", dirName, decade);
+        unlink(fileName);
+    }
+    snprintf(fileName, sizeof(fileName), "%s/jobs.txt", dirName);
+    unlink(fileName);
+    rmdir(dirName);
+
+    if (!retVal)
+    {
+        fprintf(stderr, "benchBatch error: A job did not pass\n");
+        return 1;
+    }
+    return 0;
+}
+
+/* Writes a program counting x5 down from iterations to zero and exiting */
+bool writeLoop(const char* fileName, uint32_t iterations)
+{
+    uint32_t upper = (iterations + 0x800) >> 12;   // lui takes the upper bits rounded for the sign extended addi
+    uint32_t lower = iterations - (upper << 12);
+    const uint32_t program[] = {
+        (upper << 12) | (5 << 7) | 0x37,                        // lui  x5, upper
+        (lower << 20) | (5 << 15) | (5 << 7) | 0x13,            // addi x5, x5, lower
+        0xFFF28293,                                             // addi x5, x5, -1
+        0xFE029EE3,                                             // bne  x5, x0, -4
+        0x00A00893,                                             // addi a7, x0, 10
+        0x00000073,                                             // ecall
+    };
+
+    return fileutilsWriteBinary(fileName, (uint8_t*) program, sizeof(program));
+}
+
+uint32_t iterationsOf(uint32_t decade)
+{
+    uint32_t iterations = 10;
+
+    for (uint32_t i = 0; i < decade; i++)
+    {
+        iterations *= 10;
+    }
+    return iterations;
+}
@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <time.h>
+#include "rv32i.h"
+
+/*
+Microbenchmark comparing the table driven rv32iDecodeInstructType against the nested switch decoder it replaced,
+kept below as the reference. Both decoders run over the same mix of instruction words, and their results are
+checked for equality before timing.
+
+Usage: benchDecode [number of words] [repetitions]
+*/
+
+#define DEFAULT_WORDS       (1 << 16)
+#define DEFAULT_REPETITIONS (1000)
+
+/*** Static function prototypes ***/
+static __attribute__((noinline)) rv32i_instruct_t decodeSwitch(int32_t instruct);   // Not inlined, like the library call
+static double secondsSince(const struct timespec* start);
+
+int main(int argc, char* argv[])
+{
+    static const uint8_t opcodes[] = {
+        RV32I_OPCODE_ALU, RV32I_OPCODE_ALU_IMM, RV32I_OPCODE_AUIPC, RV32I_OPCODE_BRANCH, RV32I_OPCODE_ENV,
+        RV32I_OPCODE_FEN_PAUS, RV32I_OPCODE_JAL, RV32I_OPCODE_JALR, RV32I_OPCODE_LOAD, RV32I_OPCODE_LUI, RV32I_OPCODE_STORE,
+    };
+    uint32_t nWords = (argc > 1) ? strtoul(argv[1], NULL, 0) : DEFAULT_WORDS;
+    uint32_t nReps  = (argc > 2) ? strtoul(argv[2], NULL, 0) : DEFAULT_REPETITIONS;
+    int32_t* words;
+    uint64_t sumSwitch = 0, sumTable = 0;
+    double secSwitch, secTable;
+    struct timespec start;
+
+    if (nWords == 0 || (words = malloc(nWords * sizeof(int32_t))) == NULL)
+    {
+        fprintf(stderr, "benchDecode error: Unable to allocate %u words\n", nWords);
+        return 1;
+    }
+
+    // Random fields on valid opcodes, with funct7 mostly 0b0000000 or 0b0100000 as in real programs
+    srand(1);
+    for (uint32_t i = 0; i < nWords; i++)
+    {
+        uint32_t word = ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+        word = (word & ~0b1111111u) | opcodes[rand() % sizeof(opcodes)];
+        if (rand() % 8 != 0)
+        {
+            word &= ~((uint32_t) 0b1011111 << 25);
+        }
+        words[i] = (int32_t) word;
+    }
+    for (uint32_t i = 0; i < nWords; i++)
+    {
+        if (decodeSwitch(words[i]) != rv32iDecodeInstructType(words[i]))
+        {
+            fprintf(stderr, "benchDecode error: Decoders disagree on 0x%08x\n", (uint32_t) words[i]);
+            free(words);
+            return 1;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t rep = 0; rep < nReps; rep++)
+    {
+        for (uint32_t i = 0; i < nWords; i++)
+        {
+            sumSwitch += decodeSwitch(words[i]);
+        }
+    }
+    secSwitch = secondsSince(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t rep = 0; rep < nReps; rep++)
+    {
+        for (uint32_t i = 0; i < nWords; i++)
+        {
+            sumTable += rv32iDecodeInstructType(words[i]);
+        }
+    }
+    secTable = secondsSince(&start);
+
+    printf("Decoded %u words %u times\n", nWords, nReps);
+    printf("switch: %.3f s, %.2f ns/decode\n", secSwitch, secSwitch * 1e9 / ((double) nWords * nReps));
+    printf("table:  %.3f s, %.2f ns/decode\n", secTable,  secTable  * 1e9 / ((double) nWords * nReps));
+    printf("speedup: %.2fx\n", secSwitch / secTable);
+
+    free(words);
+    return (sumSwitch == sumTable) ? 0 : 1;
+}
+
+double secondsSince(const struct timespec* start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/* Nested switch decoder from before the decode tables, kept as the reference */
+rv32i_instruct_t decodeSwitch(int32_t instruct)
+{
+    uint8_t opcode, funct3, funct7;
+    uint16_t funct12;
+
+    opcode  = rv32iGetOpcode(instruct);
+    funct3  = rv32iGetFunct3(instruct);
+    funct7  = rv32iGetFunct7(instruct);
+    funct12 = rv32iGetFunct12(instruct);
+
+    switch (opcode)
+    {
+    case RV32I_OPCODE_ALU:
+        switch (funct3)
+        {
+        case 0b000:
+            switch (funct7)
+            {
+            case 0b0000000:
+                return RV32I_ADD;
+            case 0b0100000:
+                return RV32I_SUB;
+            default:
+                return RV32I_NOT_SUPPORTED;
+            }
+        case 0b001:
+            return RV32I_SLL;
+        case 0b010:
+            return RV32I_SLT;
+        case 0b011:
+            return RV32I_SLTU;
+        case 0b100:
+            return RV32I_XOR;
+        case 0b101:
+            switch (funct7)
+            {
+            case 0b0000000:
+                return RV32I_SRL;
+            case 0b0100000:
+                return RV32I_SRA;
+            default:
+                return RV32I_NOT_SUPPORTED;
+            }
+        case 0b110:
+            return RV32I_OR;
+        case 0b111:
+            return RV32I_AND;
+        default:
+            assert(0); // This condition should be unreachable.
+            return RV32I_NOT_SUPPORTED;
+        }
+        break;
+    case RV32I_OPCODE_ALU_IMM:
+        switch (funct3)
+        {
+        case 0b000:
+            return RV32I_ADDI;
+        case 0b010:
+            return RV32I_SLTI;
+        case 0b011:
+            return RV32I_SLTIU;
+        case 0b100:
+            return RV32I_XORI;
+        case 0b110:
+            return RV32I_ORI;
+        case 0b111:
+            return RV32I_ANDI;
+        case 0b001:
+            return RV32I_SLLI;
+        case 0b101:
+            switch (funct7)
+            {
+            case 0b0000000:
+                return RV32I_SRLI;
+            case 0b0100000:
+                return RV32I_SRAI;
+            default:
+                return RV32I_NOT_SUPPORTED;
+            }
+        default:
+            assert(0); // This condition should be unreachable.
+            return RV32I_NOT_SUPPORTED;
+        }
+    case RV32I_OPCODE_AUIPC:
+        return RV32I_AUIPC;
+    case RV32I_OPCODE_BRANCH:
+        switch (funct3)
+        {
+        case 0b000:
+            return RV32I_BEQ;
+        case 0b001:
+            return RV32I_BNE;
+        case 0b100:
+            return RV32I_BLT;
+        case 0b101:
+            return RV32I_BGE;
+        case 0b110:
+            return RV32I_BLTU;
+        case 0b111:
+            return RV32I_BGEU;
+        default:
+            return RV32I_NOT_SUPPORTED;
+        }
+    case RV32I_OPCODE_ENV:
+        switch (funct12)
+        {
+        case 0b000000000000:
+            return RV32I_ECALL;
+        default:
+            return RV32I_NOT_SUPPORTED;
+        }
+    case RV32I_OPCODE_FEN_PAUS:
+        return RV32I_NOT_SUPPORTED;
+    case RV32I_OPCODE_JAL:
+        return RV32I_JAL;
+    case RV32I_OPCODE_JALR:
+        return RV32I_JALR;
+    case RV32I_OPCODE_LOAD:
+        switch (funct3)
+        {
+        case 0b000:
+            return RV32I_LB;
+        case 0b001:
+            return RV32I_LH;
+        case 0b010:
+            return RV32I_LW;
+        case 0b100:
+            return RV32I_LBU;
+        case 0b101:
+            return RV32I_LHU;
+        default:
+            return RV32I_NOT_SUPPORTED;
+        }
+    case RV32I_OPCODE_LUI:
+        return RV32I_LUI;
+    case RV32I_OPCODE_STORE:
+        switch (funct3)
+        {
+        case 0b000:
+            return RV32I_SB;
+        case 0b001:
+            return RV32I_SH;
+        case 0b010:
+            return RV32I_SW;
+        default:
+            return RV32I_NOT_SUPPORTED;
+        }
+    default:
+        return RV32I_NOT_SUPPORTED;
+    }
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/*
+Microbenchmark of the per-instruction cost of the rv32i hot path helpers, called across the rv32i library boundary
+against the static inline variant from rv32iInline.h. Both runs use the same kernel, benchInlineKernel.c, compiled
+once in each configuration.
+
+Usage: benchInline [number of words] [repetitions]
+*/
+
+#define DEFAULT_WORDS       (1 << 16)
+#define DEFAULT_REPETITIONS (1000)
+#define MEM_SIZE            (1 << 16)
+
+uint64_t benchKernelCall  (uint8_t* prog, uint32_t nWords, uint8_t* mem, uint32_t memMask, int32_t regFile[32]);
+uint64_t benchKernelInline(uint8_t* prog, uint32_t nWords, uint8_t* mem, uint32_t memMask, int32_t regFile[32]);
+
+typedef uint64_t (*kernel_t)(uint8_t* prog, uint32_t nWords, uint8_t* mem, uint32_t memMask, int32_t regFile[32]);
+
+/*** Static function prototypes ***/
+static double runKernel(kernel_t kernel, uint8_t* prog, uint32_t nWords, uint32_t nReps, uint8_t* mem, uint64_t* sum);
+
+int main(int argc, char* argv[])
+{
+    uint32_t nWords = (argc > 1) ? strtoul(argv[1], NULL, 0) : DEFAULT_WORDS;
+    uint32_t nReps  = (argc > 2) ? strtoul(argv[2], NULL, 0) : DEFAULT_REPETITIONS;
+    uint8_t* prog;
+    uint8_t* mem;
+    uint64_t sumCall, sumInline;
+    double secCall, secInline, nInstructs;
+
+    prog = malloc((size_t) nWords * 4);
+    mem  = malloc(MEM_SIZE);
+    if (nWords == 0 || prog == NULL || mem == NULL)
+    {
+        fprintf(stderr, "benchInline error: Unable to allocate %u words\n", nWords);
+        free(prog);
+        free(mem);
+        return 1;
+    }
+
+    srand(1);
+    for (uint32_t i = 0; i < nWords * 4; i++)
+    {
+        prog[i] = rand();
+    }
+
+    secCall   = runKernel(benchKernelCall,   prog, nWords, nReps, mem, &sumCall);
+    secInline = runKernel(benchKernelInline, prog, nWords, nReps, mem, &sumInline);
+    nInstructs = (double) nWords * nReps;
+
+    printf("Executed %u words %u times\n", nWords, nReps);
+    printf("library call: %.3f s, %.2f ns/instruction\n", secCall,   secCall   * 1e9 / nInstructs);
+    printf("inline:       %.3f s, %.2f ns/instruction\n", secInline, secInline * 1e9 / nInstructs);
+    printf("speedup: %.2fx\n", secCall / secInline);
+
+    free(prog);
+    free(mem);
+    if (sumCall != sumInline)
+    {
+        fprintf(stderr, "benchInline error: Kernels disagree\n");
+        return 1;
+    }
+    return 0;
+}
+
+/* Runs kernel from the same initial state, returning the wall-clock time */
+double runKernel(kernel_t kernel, uint8_t* prog, uint32_t nWords, uint32_t nReps, uint8_t* mem, uint64_t* sum)
+{
+    int32_t regFile[32] = {0};
+    struct timespec start, end;
+
+    memset(mem, 0, MEM_SIZE);
+    *sum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t rep = 0; rep < nReps; rep++)
+    {
+        *sum += kernel(prog, nWords, mem, MEM_SIZE - 4, regFile);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
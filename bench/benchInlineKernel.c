@@ -0,0 +1,44 @@
+#include <stdint.h>
+#include "rv32i.h"
+
+/*
+Interpreter shaped kernel for benchInline. Compiled twice, once against the out-of-line rv32i library and once with
+RV32I_USE_INLINE, with BENCH_KERNEL naming each copy. Every word is fetched, its fields extracted and one load and
+store done through the rv32i helpers, as a simulator does per instruction.
+*/
+
+uint64_t BENCH_KERNEL(uint8_t* prog, uint32_t nWords, uint8_t* mem, uint32_t memMask, int32_t regFile[32])
+{
+    uint64_t sum = 0;
+    int32_t  instruct;
+    uint32_t adr;
+    uint8_t  rd, rs1, rs2;
+
+    for (uint32_t i = 0; i < nWords; i++)
+    {
+        instruct = rv32iLoadWord(prog + 4 * i);
+        rd  = rv32iGetRd(instruct);
+        rs1 = rv32iGetRs1(instruct);
+        rs2 = rv32iGetRs2(instruct);
+        adr = (regFile[rs1] + rv32iGetFunct7(instruct)) & memMask;
+
+        switch (rv32iGetFunct3(instruct) & 0b11)
+        {
+        case 0b00:
+            rv32iStoreByte(mem + adr, regFile[rs2]);
+            regFile[rd] = rv32iSignExtentByte(rv32iLoadByte(mem + adr));
+            break;
+        case 0b01:
+            rv32iStoreHalfWord(mem + adr, regFile[rs2]);
+            regFile[rd] = rv32iSignExtentHalfWord(rv32iLoadHalfWord(mem + adr));
+            break;
+        default:
+            rv32iStoreWord(mem + adr, regFile[rs2] + rv32iGetOpcode(instruct));
+            regFile[rd] = rv32iLoadWord(mem + adr);
+            break;
+        }
+        regFile[0] = 0;
+        sum += (uint32_t) regFile[rd];
+    }
+    return sum;
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include "fileutils.h"
+#include "guestMem.h"
+#include "sim.h"
+
+/*
+Benchmark of running the same program many times from its initial memory. Each run either reads the image into a
+freshly allocated memory with fileutilsReadBinary, maps it into a fresh guest memory with fileutilsMapBinary, or
+resets a tracked guest memory by copying back the pages the previous run wrote. All runs use the soft engine, and
+the register files of the last runs are compared.
+
+Usage: benchReset <program.bin> [runs] [memory size in bytes]
+*/
+
+#define DEFAULT_RUNS        (10000)
+
+/*** Static function prototypes ***/
+static double elapsed(const struct timespec* start);
+static void   report(const char* name, double seconds, uint32_t nRuns, uint64_t instructCount);
+
+int main(int argc, char* argv[])
+{
+    const char* fileName = (argc > 1) ? argv[1] : NULL;
+    uint32_t nRuns = (argc > 2) ? strtoul(argv[2], NULL, 0) : DEFAULT_RUNS;
+    uint64_t memSize = (argc > 3) ? strtoull(argv[3], NULL, 0) : GUEST_MEM_DEFAULT_BYTES;
+    sim_options_t options = {};
+    sim_stats_t stats;
+    sim_state_t readState = {}, mapState = {}, resetState = {};
+    guest_mem_t mem = {};
+    guest_mem_t image = {};
+    uint8_t* prog;
+    struct timespec start;
+    double secRead, secMap, secReset;
+
+    if (fileName == NULL || nRuns == 0)
+    {
+        fprintf(stderr, "Usage: %s <program.bin> [runs] [memory size in bytes]\n", argv[0]);
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t run = 0; run < nRuns; run++)
+    {
+        if ( (prog = fileutilsReadBinary(fileName, memSize)) == NULL )
+        {
+            return 1;
+        }
+        readState = (sim_state_t) {};
+        simRun(SIM_ENGINE_SOFT, prog, memSize, &readState, &options, &stats);
+        free(prog);
+    }
+    secRead = elapsed(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t run = 0; run < nRuns; run++)
+    {
+        if ( !guestMemCreate(&mem, memSize) || fileutilsMapBinary(fileName, mem.base, mem.size) < 0 )
+        {
+            return 1;
+        }
+        mapState = (sim_state_t) {};
+        simRun(SIM_ENGINE_SOFT, mem.base, mem.size, &mapState, &options, &stats);
+        guestMemDestroy(&mem);
+    }
+    secMap = elapsed(&start);
+
+    // The image is loaded once, and the memory run in is loaded once and then tracked
+    if ( !guestMemCreate(&image, memSize) || fileutilsMapBinary(fileName, image.base, image.size) < 0 ||
+         !guestMemCreate(&mem, memSize)   || fileutilsMapBinary(fileName, mem.base, mem.size) < 0 || !guestMemTrack(&mem) )
+    {
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t run = 0; run < nRuns; run++)
+    {
+        guestMemReset(&mem, &image);
+        resetState = (sim_state_t) {};
+        simRun(SIM_ENGINE_SOFT, mem.base, mem.size, &resetState, &options, &stats);
+    }
+    secReset = elapsed(&start);
+    guestMemDestroy(&mem);
+    guestMemDestroy(&image);
+
+    printf("Ran %s %u times, %" PRIu64 " instructions each\n", fileName, nRuns, resetState.instructCount);
+    report("read:  ", secRead,  nRuns, readState.instructCount);
+    report("map:   ", secMap,   nRuns, mapState.instructCount);
+    report("reset: ", secReset, nRuns, resetState.instructCount);
+    printf("speedup of reset over read: %.2fx\n", secRead / secReset);
+
+    if ( memcmp(readState.regFile, resetState.regFile, sizeof(readState.regFile)) != 0 ||
+         memcmp(mapState.regFile,  resetState.regFile, sizeof(mapState.regFile))  != 0 )
+    {
+        fprintf(stderr, "benchReset error: Register files disagree\n");
+        return 1;
+    }
+    return 0;
+}
+
+double elapsed(const struct timespec* start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+void report(const char* name, double seconds, uint32_t nRuns, uint64_t instructCount)
+{
+    printf("%s %.3f s, %.2f us/run, %" PRIu64 " instructions\n", name, seconds, seconds * 1e6 / nRuns, instructCount);
+}
@@ -0,0 +1,634 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "batch.h"
+
+/*
+Each worker owns a deque of job indices, filled with a range of consecutive jobs. The owner takes jobs from the head,
+in manifest order, and a worker whose deque is empty steals from the tail of another, starting at a random victim.
+Jobs last from microseconds to seconds, so a mutex per deque costs nothing measurable and keeps the deques simple.
+Workers with nothing to steal sleep until a suspended job is queued or the last job finishes.
+
+A suspended job takes its memory and engine context along and is pushed to the tail of its worker's deque, where an idle worker is the
+first to steal it. Each worker keeps the guest memory of its last job. When a worker gets the same input twice in a
+row it loads a second copy as an image and tracks the pages written to the memory it runs in, and from then on
+resets those pages from the image for each further run of that input. Inputs run once are loaded once and never
+tracked.
+*/
+
+#define MANIFEST_FIELDS     " \t\r"
+#define DEQUE_MIN_CAPACITY  (16)
+
+/* Status names for the report, indexed by batch_status_t */
+static const char* statusNames[] = {
+    [BATCH_PENDING] = "SKIP",
+    [BATCH_PASS]    = "PASS",
+    [BATCH_FAIL]    = "FAIL",
+    [BATCH_ERROR]   = "ERROR",
+};
+
+/* Ring of job indices */
+typedef struct deque_t
+{
+    pthread_mutex_t lock;
+    uint32_t*       jobs;
+    uint32_t        capacity;
+    uint32_t        head;       // Position of the job the owner takes next
+    uint32_t        count;
+} deque_t;
+
+typedef struct worker_t
+{
+    pthread_t      thread;
+    struct pool_t* pool;
+    deque_t        deque;
+    uint32_t       seed;        // Victim selection state
+    guest_mem_t    mem;         // Memory of the last job
+    guest_mem_t    image;       // Initial memory of the input of the last job, once run twice in a row
+    const char*    loaded;      // Input of the last job, NULL if it failed to load or was suspended
+    uint32_t       entry;       // Start PC of loaded
+} worker_t;
+
+/* State shared by the workers of one batchRun */
+typedef struct pool_t
+{
+    batch_t*               batch;
+    const batch_options_t* options;
+    worker_t*              workers;
+    uint32_t               threads;     // Workers, including those whose thread failed to start
+    atomic_uint            remaining;   // Jobs not finished
+    atomic_int             queued;      // Jobs in the deques, briefly negative when a queued job is taken before it is counted
+    atomic_ullong          steals;
+    pthread_mutex_t        idleLock;    // Guards sleeping on idle against the changes of queued and remaining it waits for
+    pthread_cond_t         idle;
+    pthread_mutex_t        progressLock;
+} pool_t;
+
+/*** Static function prototypes ***/
+static char* readText(const char* fileName);
+static void* workerMain(void* arg);
+static bool  takeJob(worker_t* worker, uint32_t* index);
+static bool  stealJob(worker_t* worker, uint32_t* index);
+static bool  requeueJob(worker_t* worker, uint32_t index);
+static void  finishJob(pool_t* pool, const batch_job_t* job);
+static bool  runJob(worker_t* worker, batch_job_t* job);
+static bool  prepare(worker_t* worker, const char* fileName, uint32_t* pc);
+static bool  loadInput(guest_mem_t* mem, const char* fileName, const batch_options_t* options, uint32_t* pc);
+static bool  dequeInit(deque_t* deque, uint32_t first, uint32_t count);
+static void  dequeDestroy(deque_t* deque);
+static bool  dequePush(deque_t* deque, uint32_t index);
+static bool  dequeTake(deque_t* deque, bool head, uint32_t* index);
+static double elapsed(const struct timespec* start);
+
+/* Reads the jobs listed in the manifest fileName into batch. Returns false on failure, leaving batch empty. */
+bool batchReadManifest(const char* fileName, batch_t* batch)
+{
+    char* fields[4];
+    char* line;
+    char* next;
+    char* save;
+    char* comment;
+    batch_job_t* grown;
+    uint32_t capacity = 0;
+    uint32_t lineNumber = 0;
+    uint32_t nFields;
+
+    *batch = (batch_t) {};
+    if ( (batch->text = readText(fileName)) == NULL )
+    {
+        return false;
+    }
+
+    for (line = batch->text; line != NULL; line = next)
+    {
+        lineNumber++;
+        if ( (next = strchr(line, '\n')) != NULL )
+        {
+            *next++ = '\0';
+        }
+        if ( (comment = strchr(line, '#')) != NULL )
+        {
+            *comment = '\0';
+        }
+        nFields = 0;
+        for (char* field = strtok_r(line, MANIFEST_FIELDS, &save); field != NULL && nFields < 4; field = strtok_r(NULL, MANIFEST_FIELDS, &save))
+        {
+            fields[nFields++] = field;
+        }
+        if (nFields == 0)
+        {
+            continue;
+        }
+        if (nFields > 3 || strcmp(fields[0], FILEUTILS_STDIN_NAME) == 0)
+        {
+            fprintf(stderr, "batch error: Manifest line %" PRIu32 " is not <input> [<output>|-] [<expected>]\n", lineNumber);
+            batchFree(batch);
+            return false;
+        }
+
+        if (batch->count == capacity)
+        {
+            capacity = (capacity == 0) ? 64 : 2 * capacity;
+            if ( (grown = realloc(batch->jobs, capacity * sizeof(batch_job_t))) == NULL )
+            {
+                fprintf(stderr, "batch error: Failed to allocate memory for %" PRIu32 " jobs\n", capacity);
+                batchFree(batch);
+                return false;
+            }
+            batch->jobs = grown;
+        }
+        batch->jobs[batch->count++] = (batch_job_t) {
+            .inFileName     = fields[0],
+            .outFileName    = (nFields > 1 && strcmp(fields[1], "-") != 0) ? fields[1] : NULL,
+            .expectFileName = (nFields > 2) ? fields[2] : NULL,
+        };
+    }
+
+    if (batch->count == 0)
+    {
+        fprintf(stderr, "batch error: No jobs in manifest '%s'\n", fileName);
+        batchFree(batch);
+        return false;
+    }
+    return true;
+}
+
+void batchFree(batch_t* batch)
+{
+    free(batch->jobs);
+    free(batch->text);
+    *batch = (batch_t) {};
+}
+
+/* Runs all jobs of batch on a pool of worker threads, the calling thread being one of them, and fills in their
+   results. Returns false if no job could be run. */
+bool batchRun(batch_t* batch, const batch_options_t* options)
+{
+    pool_t pool = { .batch = batch, .options = options };
+    worker_t* workers;
+    uint32_t threads = options->threads;
+    uint32_t started = 1;
+    bool retVal = true;
+    struct timespec start;
+
+    if (threads == 0)
+    {
+        threads = (uint32_t) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    threads = (threads > batch->count) ? batch->count : threads;
+    threads = (threads > BATCH_MAX_THREADS) ? BATCH_MAX_THREADS : threads;
+    threads = (threads == 0) ? 1 : threads;
+    if ( (workers = calloc(threads, sizeof(worker_t))) == NULL )
+    {
+        fprintf(stderr, "batch error: Failed to allocate memory for %" PRIu32 " workers\n", threads);
+        return false;
+    }
+    for (uint32_t i = 0; i < batch->count; i++)
+    {
+        batch->jobs[i].status  = BATCH_PENDING;
+        batch->jobs[i].seconds = 0.0;
+        batch->jobs[i].slices  = 0;
+        batch->jobs[i].context = NULL;
+    }
+
+    // Consecutive jobs per worker, so repeated inputs listed together stay on one worker
+    for (uint32_t i = 0; i < threads && retVal; i++)
+    {
+        workers[i].pool = &pool;
+        workers[i].seed = i + 1;
+        retVal = dequeInit(&workers[i].deque, (uint64_t) batch->count * i / threads,
+                           (uint64_t) batch->count * (i + 1) / threads - (uint64_t) batch->count * i / threads);
+    }
+    if (!retVal)
+    {
+        fprintf(stderr, "batch error: Failed to allocate memory for the job queues\n");
+        for (uint32_t i = 0; i < threads; i++)
+        {
+            dequeDestroy(&workers[i].deque);
+        }
+        free(workers);
+        return false;
+    }
+    pool.workers = workers;
+    pool.threads = threads;
+    atomic_init(&pool.remaining, batch->count);
+    atomic_init(&pool.queued, (int) batch->count);
+    atomic_init(&pool.steals, 0);
+    pthread_mutex_init(&pool.idleLock, NULL);
+    pthread_cond_init(&pool.idle, NULL);
+    pthread_mutex_init(&pool.progressLock, NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    // Fewer workers than asked for still run every job, stealing the jobs of those not started
+    for ( ; started < threads && pthread_create(&workers[started].thread, NULL, workerMain, &workers[started]) == 0; started++ );
+    workerMain(&workers[0]);
+    for (uint32_t i = 1; i < started; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+    }
+    batch->threads = started;
+    batch->steals  = atomic_load(&pool.steals);
+    batch->seconds = elapsed(&start);
+
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        dequeDestroy(&workers[i].deque);
+    }
+    pthread_mutex_destroy(&pool.idleLock);
+    pthread_cond_destroy(&pool.idle);
+    pthread_mutex_destroy(&pool.progressLock);
+    free(workers);
+    return true;
+}
+
+/* Prints the outcome of every job and a summary line. Returns the number of jobs that did not pass. */
+uint32_t batchReport(FILE* stream, const batch_t* batch)
+{
+    for (uint32_t i = 0; i < batch->count; i++)
+    {
+        batchPrintJob(stream, &batch->jobs[i]);
+    }
+    return batchSummary(stream, batch);
+}
+
+/* Prints the summary line of a run batch. Returns the number of jobs that did not pass. */
+uint32_t batchSummary(FILE* stream, const batch_t* batch)
+{
+    uint32_t counts[sizeof(statusNames)/sizeof(statusNames[0])] = {0};
+
+    for (uint32_t i = 0; i < batch->count; i++)
+    {
+        counts[batch->jobs[i].status]++;
+    }
+    fprintf(stream, "Batch: %" PRIu32 " jobs, %" PRIu32 " passed, %" PRIu32 " failed, %" PRIu32 " errors, %" PRIu32 " threads, %.6f s\n",
+            batch->count, counts[BATCH_PASS], counts[BATCH_FAIL], counts[BATCH_ERROR], batch->threads, batch->seconds);
+
+    return batch->count - counts[BATCH_PASS];
+}
+
+/* Prints the outcome of a job, and the differing registers if it failed */
+void batchPrintJob(FILE* stream, const batch_job_t* job)
+{
+    fprintf(stream, "%-5s %10.6f s %12" PRIu64 " instructions  %s\n", statusNames[job->status], job->seconds,
+            job->state.instructCount, job->inFileName);
+    if (job->status == BATCH_FAIL)
+    {
+        batchPrintDiff(stream, job);
+    }
+}
+
+/* Prints every register that differs from the expected register file */
+void batchPrintDiff(FILE* stream, const batch_job_t* job)
+{
+    for (int i = 0; i < SIM_REG_COUNT; i++)
+    {
+        if (job->state.regFile[i] != job->expected[i])
+        {
+            fprintf(stream, "    x%-2d expected 0x%08x, got 0x%08x\n", i, (uint32_t) job->expected[i], (uint32_t) job->state.regFile[i]);
+        }
+    }
+}
+
+/* Returns the contents of fileName with a terminating NUL, or NULL on failure */
+char* readText(const char* fileName)
+{
+    FILE* file;
+    char* text = NULL;
+    long size;
+
+    if ( (file = fopen(fileName, "rb")) == NULL )
+    {
+        perror("batch error: Failed opening manifest");
+        return NULL;
+    }
+    if ( fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0 ||
+         (text = malloc((size_t) size + 1)) == NULL || fread(text, 1, (size_t) size, file) != (size_t) size )
+    {
+        fprintf(stderr, "batch error: Failed reading manifest '%s'\n", fileName);
+        free(text);
+        text = NULL;
+    }
+    else
+    {
+        text[size] = '\0';
+    }
+    fclose(file);
+
+    return text;
+}
+
+void* workerMain(void* arg)
+{
+    worker_t* worker = arg;
+    batch_job_t* job;
+    uint32_t i;
+    bool finished;
+
+    while (takeJob(worker, &i))
+    {
+        job = &worker->pool->batch->jobs[i];
+        // A suspended job that cannot be queued keeps running here
+        for (finished = runJob(worker, job); !finished && !requeueJob(worker, i); finished = runJob(worker, job));
+        if (finished)
+        {
+            finishJob(worker->pool, job);
+        }
+    }
+    guestMemDestroy(&worker->mem);
+    guestMemDestroy(&worker->image);
+    return NULL;
+}
+
+/* Takes the next job of the worker's deque, or steals one, and sleeps while none is queued. Returns false once all
+   jobs are finished. */
+bool takeJob(worker_t* worker, uint32_t* index)
+{
+    pool_t* pool = worker->pool;
+    bool done;
+
+    for (;;)
+    {
+        if (dequeTake(&worker->deque, true, index) || stealJob(worker, index))
+        {
+            atomic_fetch_sub(&pool->queued, 1);
+            return true;
+        }
+        pthread_mutex_lock(&pool->idleLock);
+        while (atomic_load(&pool->queued) <= 0 && atomic_load(&pool->remaining) != 0)
+        {
+            pthread_cond_wait(&pool->idle, &pool->idleLock);
+        }
+        done = atomic_load(&pool->remaining) == 0;
+        pthread_mutex_unlock(&pool->idleLock);
+        if (done)
+        {
+            return false;
+        }
+    }
+}
+
+/* Takes a job from the tail of another worker's deque, trying every other worker once from a random one */
+bool stealJob(worker_t* worker, uint32_t* index)
+{
+    pool_t* pool = worker->pool;
+    uint32_t first;
+    worker_t* victim;
+
+    worker->seed ^= worker->seed << 13;     // xorshift32
+    worker->seed ^= worker->seed >> 17;
+    worker->seed ^= worker->seed << 5;
+    first = worker->seed % pool->threads;
+    for (uint32_t i = 0; i < pool->threads; i++)
+    {
+        victim = &pool->workers[(first + i) % pool->threads];
+        if (victim != worker && dequeTake(&victim->deque, false, index))
+        {
+            atomic_fetch_add(&pool->steals, 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Queues a suspended job behind the other jobs of the worker, and wakes a sleeping worker to steal it. Returns false
+   on failure. */
+bool requeueJob(worker_t* worker, uint32_t index)
+{
+    pool_t* pool = worker->pool;
+
+    if (!dequePush(&worker->deque, index))
+    {
+        return false;
+    }
+    pthread_mutex_lock(&pool->idleLock);
+    atomic_fetch_add(&pool->queued, 1);
+    pthread_cond_signal(&pool->idle);
+    pthread_mutex_unlock(&pool->idleLock);
+    return true;
+}
+
+/* Reports a finished job to the progress stream, and wakes all sleeping workers to return once it is the last */
+void finishJob(pool_t* pool, const batch_job_t* job)
+{
+    if (pool->options->progress != NULL)
+    {
+        pthread_mutex_lock(&pool->progressLock);
+        batchPrintJob(pool->options->progress, job);
+        fflush(pool->options->progress);
+        pthread_mutex_unlock(&pool->progressLock);
+    }
+    if (atomic_fetch_sub(&pool->remaining, 1) == 1)
+    {
+        pthread_mutex_lock(&pool->idleLock);
+        pthread_cond_broadcast(&pool->idle);
+        pthread_mutex_unlock(&pool->idleLock);
+    }
+}
+
+/* Runs job for up to one time slice, loading it first if it has not run yet. Returns false if it was suspended at
+   the end of the slice, with its memory moved into the job. */
+bool runJob(worker_t* worker, batch_job_t* job)
+{
+    const batch_options_t* options = worker->pool->options;
+    sim_options_t simOptions = {};
+    sim_stats_t stats;
+    guest_mem_t* mem = (job->mem.base != NULL) ? &job->mem : &worker->mem;
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (job->slices == 0)
+    {
+        job->state  = (sim_state_t) {};
+        job->status = BATCH_ERROR;
+        if (!prepare(worker, job->inFileName, &job->state.pc))
+        {
+            job->seconds = elapsed(&start);
+            return true;
+        }
+    }
+    if (options->slice != 0 && job->context == NULL)
+    {
+        job->context = simContextCreate(options->engine, mem->base, mem->size);   // Runs cold each slice if NULL
+    }
+    job->slices++;
+    simOptions.instructLimit = (options->slice != 0) ? job->state.instructCount + options->slice : 0;
+    simOptions.context       = job->context;
+    job->simResult = simRun(options->engine, mem->base, mem->size, &job->state, &simOptions, &stats);
+
+    if (job->simResult == SIM_RUN_LIMIT)
+    {
+        if (mem == &worker->mem)
+        {
+            job->mem       = worker->mem;
+            worker->mem    = (guest_mem_t) {};
+            worker->loaded = NULL;
+        }
+        job->seconds += elapsed(&start);
+        return false;
+    }
+    // As for RiVIS -o, only a faulted run has no register file to write and compare
+    if ( job->simResult != SIM_RUN_FAULT &&
+         (job->outFileName == NULL ||
+          fileutilsWriteBinary(job->outFileName, (uint8_t*) job->state.regFile, BATCH_REG_FILE_BYTES)) )
+    {
+        if (job->expectFileName == NULL)
+        {
+            job->status = (job->simResult >= 0) ? BATCH_PASS : BATCH_ERROR;
+        }
+        else if (fileutilsLoadBinary(job->expectFileName, (uint8_t*) job->expected, sizeof(job->expected)) == BATCH_REG_FILE_BYTES)
+        {
+            job->status = (memcmp(job->state.regFile, job->expected, BATCH_REG_FILE_BYTES) == 0) ? BATCH_PASS : BATCH_FAIL;
+        }
+    }
+    simContextDestroy(job->context);
+    job->context = NULL;
+    guestMemDestroy(&job->mem);
+    job->seconds += elapsed(&start);
+    return true;
+}
+
+/* Sets up the worker's memory with the initial memory of fileName, and *pc to its start PC */
+bool prepare(worker_t* worker, const char* fileName, uint32_t* pc)
+{
+    const batch_options_t* options = worker->pool->options;
+    bool again = worker->loaded != NULL && strcmp(worker->loaded, fileName) == 0;
+
+    if (again && worker->image.base != NULL)
+    {
+        guestMemReset(&worker->mem, &worker->image);
+        *pc = worker->entry;
+        return true;
+    }
+
+    guestMemDestroy(&worker->mem);
+    guestMemDestroy(&worker->image);
+    worker->loaded = NULL;
+    if (!loadInput(&worker->mem, fileName, options, pc))
+    {
+        return false;
+    }
+    // Run twice in a row, so keep an image to reset from. Without it every run loads the input.
+    if (again && ( !loadInput(&worker->image, fileName, options, &worker->entry) || !guestMemTrack(&worker->mem) ))
+    {
+        guestMemDestroy(&worker->image);
+    }
+    worker->loaded = fileName;
+    worker->entry  = *pc;
+    return true;
+}
+
+/* Creates mem and loads fileName into it. Returns false on failure, leaving mem destroyed. */
+bool loadInput(guest_mem_t* mem, const char* fileName, const batch_options_t* options, uint32_t* pc)
+{
+    if (!guestMemCreate(mem, options->memSize))
+    {
+        return false;
+    }
+    if (!fileutilsLoadProgram(fileName, options->format, mem->base, mem->size, options->loadAddress, pc))
+    {
+        guestMemDestroy(mem);
+        return false;
+    }
+    *pc = options->hasEntry ? options->entry : *pc;
+    if (*pc >= mem->size)
+    {
+        fprintf(stderr, "batch error: Start PC 0x%08x of '%s' outside guest memory\n", *pc, fileName);
+        guestMemDestroy(mem);
+        return false;
+    }
+    return true;
+}
+
+/* Creates deque holding the count jobs from first. Returns false on failure. */
+bool dequeInit(deque_t* deque, uint32_t first, uint32_t count)
+{
+    deque->capacity = (count > DEQUE_MIN_CAPACITY) ? count : DEQUE_MIN_CAPACITY;
+    if ( (deque->jobs = malloc(deque->capacity * sizeof(uint32_t))) == NULL )
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        deque->jobs[i] = first + i;
+    }
+    deque->head  = 0;
+    deque->count = count;
+    pthread_mutex_init(&deque->lock, NULL);
+    return true;
+}
+
+void dequeDestroy(deque_t* deque)
+{
+    if (deque->jobs != NULL)
+    {
+        pthread_mutex_destroy(&deque->lock);
+    }
+    free(deque->jobs);
+    deque->jobs = NULL;
+}
+
+/* Adds a job at the tail, growing the ring when full. Returns false on failure. */
+bool dequePush(deque_t* deque, uint32_t index)
+{
+    uint32_t* grown;
+    bool retVal = true;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count == deque->capacity)
+    {
+        if ( (retVal = (grown = malloc(2 * deque->capacity * sizeof(uint32_t))) != NULL) )
+        {
+            for (uint32_t i = 0; i < deque->count; i++)
+            {
+                grown[i] = deque->jobs[(deque->head + i) % deque->capacity];
+            }
+            free(deque->jobs);
+            deque->jobs      = grown;
+            deque->capacity *= 2;
+            deque->head      = 0;
+        }
+    }
+    if (retVal)
+    {
+        deque->jobs[(deque->head + deque->count) % deque->capacity] = index;
+        deque->count++;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return retVal;
+}
+
+/* Removes a job from the head or the tail. Returns false if deque is empty. */
+bool dequeTake(deque_t* deque, bool head, uint32_t* index)
+{
+    bool taken;
+
+    pthread_mutex_lock(&deque->lock);
+    if ( (taken = deque->count != 0) )
+    {
+        deque->count--;
+        if (head)
+        {
+            *index      = deque->jobs[deque->head];
+            deque->head = (deque->head + 1) % deque->capacity;
+        }
+        else
+        {
+            *index = deque->jobs[(deque->head + deque->count) % deque->capacity];
+        }
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return taken;
+}
+
+double elapsed(const struct timespec* start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
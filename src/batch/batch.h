@@ -0,0 +1,89 @@
+#ifndef BATCH_H
+#define BATCH_H
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include "fileutils.h"
+#include "guestMem.h"
+#include "sim.h"
+
+/*
+Batch execution of many programs within one process. A manifest lists one job per line as
+
+    <input> [<output>|-] [<expected>]
+
+separated by white space, with paths relative to the working directory and # starting a comment. The register file
+of a job is written to output unless it is - or missing, and compared with the register file in expected if given.
+A run ending in a fault has no register file, while one ending in another error, e.g. an unsupported ECALL, does.
+
+Jobs run concurrently on a pool of worker threads, each on its own guest memory and sim_state_t, as the engines
+keep no state outside of these. The jobs are split into consecutive ranges, one per worker, and a worker out of jobs
+steals from the others, so jobs whose run times differ by orders of magnitude still keep every worker busy. A worker
+running the same input again resets its memory from the image of the previous run rather than loading it again.
+
+With a time slice, a job that runs that many instructions is suspended, keeping its memory and state, and queued
+behind the other jobs of its worker, so a very long job does not hold up the jobs behind it. Slices are exact with
+the soft engine, end at a block boundary with the block based engines, and at a jump with the threaded engine. A
+suspended job also keeps its engine context, so the next slice starts with the code already predecoded or translated.
+*/
+
+#define BATCH_MAX_THREADS       (256)
+#define BATCH_REG_FILE_BYTES    (SIM_REG_COUNT * 4)     // Register file as written by RiVIS -o, without the discard slot
+
+/* Outcome of a job */
+typedef enum batch_status_t
+{
+    BATCH_PENDING = 0,
+    BATCH_PASS,     // Register file matches the expected one, or the run ended cleanly when none is given
+    BATCH_FAIL,     // Register file differs from the expected one
+    BATCH_ERROR,    // Input, output or expected file unusable, the run faulted, or it ended in an error with no expected file
+} batch_status_t;
+
+typedef struct batch_job_t
+{
+    const char*    inFileName;
+    const char*    outFileName;     // NULL for no output
+    const char*    expectFileName;  // NULL for no comparison
+    batch_status_t status;
+    int8_t         simResult;       // Return value of simRun
+    sim_state_t    state;           // State at the end of the run
+    int32_t        expected[SIM_REG_COUNT];
+    double         seconds;         // Wall-clock time spent loading, running and checking the job
+    uint32_t       slices;          // Time slices the job has run in
+    guest_mem_t    mem;             // Memory of the job while suspended between slices
+    sim_context_t* context;         // Engine context of mem while suspended between slices
+} batch_job_t;
+
+/* Settings shared by all jobs of a batch */
+typedef struct batch_options_t
+{
+    sim_engine_t       engine;
+    uint64_t           memSize;
+    fileutils_format_t format;
+    uint32_t           loadAddress;
+    bool               hasEntry;    // Start PC given in entry, overriding the one of each input
+    uint32_t           entry;
+    uint32_t           threads;     // Worker threads, 0 for one per online CPU
+    uint64_t           slice;       // Instructions a job runs before it is suspended and queued again, 0 for no limit
+    FILE*              progress;    // Stream each job is printed to by batchPrintJob as it finishes, NULL for none
+} batch_options_t;
+
+typedef struct batch_t
+{
+    batch_job_t* jobs;
+    uint32_t     count;
+    char*        text;      // Manifest contents, which the file names of the jobs point into
+    uint32_t     threads;   // Worker threads used by batchRun
+    uint64_t     steals;    // Jobs a worker took from the queue of another
+    double       seconds;   // Wall-clock time of batchRun
+} batch_t;
+
+bool     batchReadManifest(const char* fileName, batch_t* batch);
+void     batchFree        (batch_t* batch);
+bool     batchRun         (batch_t* batch, const batch_options_t* options);
+uint32_t batchReport      (FILE* stream, const batch_t* batch);
+uint32_t batchSummary     (FILE* stream, const batch_t* batch);
+void     batchPrintJob    (FILE* stream, const batch_job_t* job);
+void     batchPrintDiff   (FILE* stream, const batch_job_t* job);
+
+#endif // BATCH_H
@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <stdlib.h> // Supplies strtoull()
+#include <ctype.h>  // Supplies isxdigit()
 #include <getopt.h>
 #include <libgen.h> // Supplies basename()
 #include <assert.h>
@@ -6,8 +8,13 @@
 
 /* defines */
 #define DEFAULT_PROGNAME "RiVIS"
-#define OPTSTR "vi:o:h"
-#define USAGE_FMT  "Usage: %s [-v] [-i <inputfile>] [-o <outputfile>] [-h]\n-v = verbosity\n-i = input\n-o = output\n-h = help/usage\n"
+#define OPTSTR "vi:o:e:st:m:f:l:p:b:j:h"
+#define OPT_SNAPSHOT_AT     (256)   // Long options without a short form, beyond any character
+#define OPT_SNAPSHOT_FILE   (257)
+#define OPT_RESTORE         (258)
+#define OPT_SNAPSHOT_EVERY  (259)
+#define OPT_SLICE           (260)
+#define USAGE_FMT  "Usage: %s [-v] [-i <inputfile>] [-o <outputfile>] [-e <engine>] [-s] [-t <tracefile>] [-m <size>] [-f <format>] [-l <address>] [-p <address>] [--snapshot-at <instret>] [--snapshot-every <instructions>] [--snapshot-file <file>] [--restore <file>] [-b <manifest>] [-j <threads>] [--slice <instructions>] [-h]\n-v = trace instructions, -vv also prints registers (soft engine only)\n-i = input, - reads standard input\n-o = output\n-e = execution engine: soft (default), threaded, block, jit, tiered\n-s = print run statistics\n-t = write a binary instruction trace, printed by RiVIS-trace (soft engine only)\n-m = guest memory size in bytes, with optional K, M or G suffix, at most 4G (default 1M)\n-f = input format: auto (default, ELF or flat binary), raw, elf, ihex, memh (32-bit words), memh8 (bytes)\n-l = load address of flat binaries and hex images (default 0)\n-p = start PC (default the ELF or Intel HEX entry point, else the load address)\n--snapshot-at = write a snapshot once this many instructions have executed, running the soft engine up to it\n--snapshot-every = also append a checkpoint of the pages written every this many instructions after the snapshot\n--snapshot-file = snapshot written by --snapshot-at and --snapshot-every (default RiVIS.snap)\n--restore = resume the snapshot in file instead of loading an input\n-b = run every job of a manifest of '<input> [<output>|-] [<expected>]' lines instead of -i, and report pass/fail and timing\n-j = worker threads of -b (default one per CPU)\n--slice = suspend a job of -b after this many instructions and queue it behind the others\n-h = help/usage\n"
 
 /* external declarations */
 extern char *optarg;
@@ -16,10 +23,23 @@ extern int opterr, optopt; // Not used, but kept to notify later users of their
 
 /* function prototypes */
 static void usage(char *progname);
+static bool parseSize(const char* str, uint64_t* size);
+static bool parseAddress(const char* str, uint32_t* adr);
+static bool parseCount(const char* str, uint64_t* count);
+
+static const struct option longOptions[] = {
+    { "snapshot-at",    required_argument, NULL, OPT_SNAPSHOT_AT },
+    { "snapshot-every", required_argument, NULL, OPT_SNAPSHOT_EVERY },
+    { "snapshot-file",  required_argument, NULL, OPT_SNAPSHOT_FILE },
+    { "restore",        required_argument, NULL, OPT_RESTORE },
+    { "slice",          required_argument, NULL, OPT_SLICE },
+    { NULL,             0,                 NULL, 0 },
+};
 
 cli_return_values_t cliProcessInputs(int argc, char *argv[], cli_options_t* options)
 {
     int opt;
+    uint64_t count = 0;
     bool bUsage = false;
     bool bInFile = false;
     bool bUnknowArg = false;
@@ -27,7 +47,7 @@ cli_return_values_t cliProcessInputs(int argc, char *argv[], cli_options_t* opti
 
     assert(options != NULL && "options must not be NULL\n");
 
-    while( (opt = getopt(argc, argv, OPTSTR)) != EOF )
+    while( (opt = getopt_long(argc, argv, OPTSTR, longOptions, NULL)) != EOF )
     {
         switch(opt)
         {
@@ -41,6 +61,80 @@ cli_return_values_t cliProcessInputs(int argc, char *argv[], cli_options_t* opti
         case 'v':
             options->verbosity += 1;
             break;
+        case 'e':
+            options->engineName = optarg;
+            break;
+        case 's':
+            options->stats = true;
+            break;
+        case 't':
+            options->traceFileName = optarg;
+            break;
+        case 'm':
+            if (!parseSize(optarg, &options->memSize))
+            {
+                fprintf(stderr, "cli error: Invalid memory size '%s'\n", optarg);
+                bUnknowArg = true;
+            }
+            break;
+        case 'f':
+            options->formatName = optarg;
+            break;
+        case 'l':
+            if (!parseAddress(optarg, &options->loadAddress))
+            {
+                fprintf(stderr, "cli error: Invalid load address '%s'\n", optarg);
+                bUnknowArg = true;
+            }
+            break;
+        case 'p':
+            if (!parseAddress(optarg, &options->entry))
+            {
+                fprintf(stderr, "cli error: Invalid start PC '%s'\n", optarg);
+                bUnknowArg = true;
+            }
+            options->hasEntry = true;
+            break;
+        case OPT_SNAPSHOT_AT:
+            if (!parseCount(optarg, &options->snapshotAt))
+            {
+                fprintf(stderr, "cli error: Invalid snapshot instruction count '%s'\n", optarg);
+                bUnknowArg = true;
+            }
+            break;
+        case OPT_SNAPSHOT_EVERY:
+            if (!parseCount(optarg, &options->snapshotEvery))
+            {
+                fprintf(stderr, "cli error: Invalid checkpoint interval '%s'\n", optarg);
+                bUnknowArg = true;
+            }
+            break;
+        case OPT_SNAPSHOT_FILE:
+            options->snapshotFileName = optarg;
+            break;
+        case OPT_RESTORE:
+            bInFile = true; // Replaces the input
+            options->restoreFileName = optarg;
+            break;
+        case 'b':
+            bInFile = true; // Replaces the input
+            options->batchFileName = optarg;
+            break;
+        case 'j':
+            if (!parseCount(optarg, &count) || count > UINT32_MAX)
+            {
+                fprintf(stderr, "cli error: Invalid thread count '%s'\n", optarg);
+                bUnknowArg = true;
+            }
+            options->threads = (uint32_t) count;
+            break;
+        case OPT_SLICE:
+            if (!parseCount(optarg, &options->slice))
+            {
+                fprintf(stderr, "cli error: Invalid time slice '%s'\n", optarg);
+                bUnknowArg = true;
+            }
+            break;
         case 'h':
             bUsage = true;
             break;
@@ -86,3 +180,89 @@ void usage(char *progname)
 {
     fprintf(stderr, USAGE_FMT, progname?progname:DEFAULT_PROGNAME);
 }
+
+/* parseSize: parses a size in bytes with an optional binary K, M or G suffix, e.g. 64K. Accepts 1 B - 4 GiB. */
+bool parseSize(const char* str, uint64_t* size)
+{
+    char* end;
+    unsigned long long value;
+
+    if (*str < '0' || *str > '9')
+    {
+        return false;   // strtoull would accept a sign or leading white space
+    }
+    value = strtoull(str, &end, 10);
+    switch (*end)
+    {
+    case 'G':
+        value = (value > (1ULL << 32)) ? 0 : value << 10;
+        // Fallthrough
+    case 'M':
+        value = (value > (1ULL << 32)) ? 0 : value << 10;
+        // Fallthrough
+    case 'K':
+        value = (value > (1ULL << 32)) ? 0 : value << 10;
+        end++;
+        break;
+    default:
+        break;
+    }
+    if (*end != '\0' || value == 0 || value > (1ULL << 32))
+    {
+        return false;
+    }
+
+    *size = value;
+    return true;
+}
+
+/* parseAddress: parses a 32-bit guest address, decimal or hex with a 0x prefix */
+bool parseAddress(const char* str, uint32_t* adr)
+{
+    char* end;
+    unsigned long long value;
+
+    if (*str < '0' || *str > '9')
+    {
+        return false;   // strtoull would accept a sign or leading white space
+    }
+    if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
+    {
+        if (!isxdigit((unsigned char) str[2]))
+        {
+            return false;
+        }
+        value = strtoull(str + 2, &end, 16);
+    }
+    else
+    {
+        value = strtoull(str, &end, 10);    // Not base 0, which takes a leading 0 for octal
+    }
+    if (*end != '\0' || value > UINT32_MAX)
+    {
+        return false;
+    }
+
+    *adr = (uint32_t) value;
+    return true;
+}
+
+/* parseCount: parses a decimal instruction count above 0 */
+bool parseCount(const char* str, uint64_t* count)
+{
+    char* end;
+    unsigned long long value;
+
+    if (*str < '0' || *str > '9')
+    {
+        return false;   // strtoull would accept a sign or leading white space
+    }
+    value = strtoull(str, &end, 10);
+    if (*end != '\0' || value == 0)
+    {
+        return false;
+    }
+
+    *count = value;
+    return true;
+}
@@ -9,6 +9,21 @@ typedef struct cli_options_t
     int8_t      verbosity;
     char*       inFileName;
     char*       outFileName;
+    char*       engineName;     // NULL selects the default engine
+    bool        stats;
+    char*       traceFileName;  // NULL when no binary trace is requested
+    uint64_t    memSize;        // Guest memory size in bytes, left unchanged without -m
+    char*       formatName;     // NULL detects the input format
+    uint32_t    loadAddress;    // Guest address of flat binaries and hex images, left unchanged without -l
+    bool        hasEntry;       // Start PC given with -p, overriding the one of the input
+    uint32_t    entry;
+    uint64_t    snapshotAt;     // Instruction count to write a snapshot at, 0 for none
+    uint64_t    snapshotEvery;  // Instructions between incremental checkpoints appended to the snapshot, 0 for none
+    char*       snapshotFileName;   // Snapshot written at snapshotAt, left unchanged without --snapshot-file
+    char*       restoreFileName;    // Snapshot to resume instead of loading an input, NULL for none
+    char*       batchFileName;  // Manifest of jobs run instead of a single input, NULL for none
+    uint32_t    threads;        // Batch worker threads, 0 for one per online CPU
+    uint64_t    slice;          // Instructions a batch job runs before it is queued again, 0 for no limit
 } cli_options_t;
 
 typedef enum cli_return_values_t
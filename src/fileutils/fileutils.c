@@ -1,10 +1,29 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "fileutils.h"
 
 extern int errno; // Used for reporting errors by stdio.h, e.g. perror()
 
+#define STREAM_CHUNK_BYTES  ( 1048576 ) // Largest read() when streaming
+
+/* Format names as accepted on the command line, indexed by fileutils_format_t */
+static const char* formatNames[] = {
+    [FILEUTILS_FORMAT_AUTO]  = "auto",
+    [FILEUTILS_FORMAT_RAW]   = "raw",
+    [FILEUTILS_FORMAT_ELF]   = "elf",
+    [FILEUTILS_FORMAT_IHEX]  = "ihex",
+    [FILEUTILS_FORMAT_MEMH]  = "memh",
+    [FILEUTILS_FORMAT_MEMH8] = "memh8",
+};
+
 /* function prototypes */
 static int32_t copyFileToMem(FILE *file, uint8_t *mem, size_t memSize);
 
@@ -41,6 +60,185 @@ uint8_t* fileutilsReadBinary(const char* fileName, size_t memSize)
     return mem;
 }
 
+/* Reads a binary file into already allocated memory. Returns the file size, or -1 on failure. */
+int32_t fileutilsLoadBinary(const char* fileName, uint8_t* mem, size_t memSize)
+{
+    int32_t fileSize = -1;
+    FILE* file = NULL;
+
+    assert(mem != NULL && "mem must not be NULL\n");
+
+    if ( (file = fopen(fileName, "rb")) != NULL )
+    {
+        if ( (fileSize = copyFileToMem(file, mem, memSize)) <= 0 )
+        {
+            fileSize = -1;
+        }
+        fclose(file);
+    }
+    else
+    {
+        perror("fileutils error: Failed opening inputfile");
+    }
+
+    return fileSize;
+}
+
+/* Maps a binary file copy-on-write to the start of already reserved memory, so pages of the program are read from
+   the page cache when first touched and stores never reach the file. mem must be page aligned, and is replaced by
+   the mapping up to the end of the page holding the last byte of the file, which reads as zero past the file end.
+   FILEUTILS_STDIN_NAME maps standard input. Pipes and other inputs that cannot be mapped are streamed into memory
+   by fileutilsStreamBinary instead.
+   Returns the file size, or -1 on failure. */
+int32_t fileutilsMapBinary(const char* fileName, uint8_t* mem, size_t memSize)
+{
+    int32_t fileSize = -1;
+    int fd;
+    struct stat status;
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    size_t mapSize;
+
+    assert(mem != NULL && "mem must not be NULL\n");
+
+    if (strcmp(fileName, FILEUTILS_STDIN_NAME) == 0)
+    {
+        fd = dup(STDIN_FILENO); // Closed like an opened file
+    }
+    else
+    {
+        fd = open(fileName, O_RDONLY);
+    }
+    if (fd < 0)
+    {
+        perror("fileutils error: Failed opening inputfile");
+        return -1;
+    }
+    if (fstat(fd, &status) != 0)
+    {
+        perror("fileutils error: Unable to get status of inputfile");
+        close(fd);
+        return -1;
+    }
+
+    mapSize = ((size_t) status.st_size + pageSize - 1) & ~(pageSize - 1);
+    if ( !S_ISREG(status.st_mode) || (uintptr_t) mem % pageSize != 0 || mapSize > memSize )
+    {
+        // Not mappable, or memory ending within the last page of the file
+        fileSize = fileutilsStreamBinary(fd, mem, memSize);
+    }
+    else if (status.st_size == 0)
+    {
+        fprintf(stderr, "fileutils error: Input file is empty\n");
+    }
+    else if (status.st_size > INT32_MAX)
+    {
+        fprintf(stderr, "fileutils error: filesize of %jd B larger than maximal program size of %d B\n", (intmax_t) status.st_size, INT32_MAX);
+    }
+    else if (mmap(mem, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) != MAP_FAILED)
+    {
+        fileSize = (int32_t) status.st_size;
+    }
+    else if (mmap(mem, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0) != MAP_FAILED)
+    {
+        // A failed fixed mapping may have removed the memory it was to replace, so zeroed pages were mapped back
+        fileSize = fileutilsStreamBinary(fd, mem, memSize);
+    }
+    else
+    {
+        perror("fileutils error: Failed to restore memory after mapping inputfile");
+    }
+    close(fd); // A mapping stays valid
+
+    return fileSize;
+}
+
+/* Reads a binary from a descriptor that need not be seekable, e.g. a pipe, in large chunks directly into already
+   allocated memory until end of file. Input beyond memSize is detected without being stored.
+   Returns the number of bytes read, or -1 on failure. */
+int32_t fileutilsStreamBinary(int fd, uint8_t* mem, size_t memSize)
+{
+    size_t  limit = (memSize < INT32_MAX) ? memSize : INT32_MAX;
+    size_t  total = 0;
+    ssize_t n;
+    uint8_t probe;
+
+    assert(mem != NULL && "mem must not be NULL\n");
+
+    do
+    {
+        n = (total < limit) ? read(fd, mem + total, (limit - total < STREAM_CHUNK_BYTES) ? limit - total : STREAM_CHUNK_BYTES)
+                            : read(fd, &probe, sizeof(probe));  // Only succeeds if the input is too large
+        if (n > 0 && total == limit)
+        {
+            fprintf(stderr, "fileutils error: Input larger than maximal program size of %zu B\n", limit);
+            return -1;
+        }
+        total += (n > 0) ? (size_t) n : 0;
+    } while (n > 0 || (n < 0 && errno == EINTR));
+
+    if (n < 0)
+    {
+        perror("fileutils error: Input not read to end");
+        return -1;
+    }
+    if (total == 0)
+    {
+        fprintf(stderr, "fileutils error: Input is empty\n");
+        return -1;
+    }
+
+    return (int32_t) total;
+}
+
+fileutils_format_t fileutilsFormatFromName(const char* name)
+{
+    if (name == NULL)
+    {
+        return FILEUTILS_FORMAT_AUTO;
+    }
+    for (size_t i = 0; i < sizeof(formatNames)/sizeof(formatNames[0]); i++)
+    {
+        if (strcmp(name, formatNames[i]) == 0)
+        {
+            return (fileutils_format_t) i;
+        }
+    }
+    return FILEUTILS_FORMAT_UNKNOWN;
+}
+
+/* Loads a program image of the given format into already reserved, page aligned memory. Flat binaries and hex images
+   are placed from loadAddress, while ELF segments go to their own addresses. entry is set to the start address of
+   an ELF executable or an Intel HEX start record, and to loadAddress otherwise. Returns false on failure. */
+bool fileutilsLoadProgram(const char* fileName, fileutils_format_t format, uint8_t* mem, uint64_t memSize, uint32_t loadAddress, uint32_t* entry)
+{
+    *entry = loadAddress;
+    if (loadAddress >= memSize)
+    {
+        fprintf(stderr, "fileutils error: Load address 0x%08x outside memory of %ju B\n", loadAddress, (uintmax_t) memSize);
+        return false;
+    }
+    if (format == FILEUTILS_FORMAT_AUTO)
+    {
+        format = fileutilsIsElf(fileName) ? FILEUTILS_FORMAT_ELF : FILEUTILS_FORMAT_RAW;
+    }
+
+    switch (format)
+    {
+    case FILEUTILS_FORMAT_ELF:
+        return fileutilsLoadElf(fileName, mem, memSize, entry);
+    case FILEUTILS_FORMAT_IHEX:
+        return fileutilsLoadIntelHex(fileName, mem, memSize, loadAddress, entry);
+    case FILEUTILS_FORMAT_MEMH:
+        return fileutilsLoadMemHex(fileName, mem, memSize, loadAddress, 4);
+    case FILEUTILS_FORMAT_MEMH8:
+        return fileutilsLoadMemHex(fileName, mem, memSize, loadAddress, 1);
+    case FILEUTILS_FORMAT_RAW:
+        return fileutilsMapBinary(fileName, mem + loadAddress, memSize - loadAddress) >= 0;
+    default:
+        return false;
+    }
+}
+
 bool fileutilsWriteBinary(const char *fileName, const uint8_t *mem, size_t memSize)
 {
     FILE* file = NULL;
@@ -4,7 +4,30 @@
 #include <stdbool.h>
 #include <stddef.h> // For size_t
 
+#define FILEUTILS_STDIN_NAME    "-"     // File name reading the binary from standard input
+
+/* Program image formats */
+typedef enum fileutils_format_t
+{
+    FILEUTILS_FORMAT_UNKNOWN = -1,
+    FILEUTILS_FORMAT_AUTO = 0,  // ELF if the file starts with the ELF magic number, and a flat binary otherwise
+    FILEUTILS_FORMAT_RAW,       // Flat binary
+    FILEUTILS_FORMAT_ELF,       // ELF32 RISC-V executable
+    FILEUTILS_FORMAT_IHEX,      // Intel HEX
+    FILEUTILS_FORMAT_MEMH,      // Verilog $readmemh of 32-bit words
+    FILEUTILS_FORMAT_MEMH8,     // Verilog $readmemh of bytes
+} fileutils_format_t;
+
 uint8_t* fileutilsReadBinary (const char* fileName, size_t memSize);
+int32_t  fileutilsLoadBinary (const char* fileName, uint8_t* mem, size_t memSize);
+int32_t  fileutilsMapBinary  (const char* fileName, uint8_t* mem, size_t memSize);
+int32_t  fileutilsStreamBinary(int fd, uint8_t* mem, size_t memSize);
+bool     fileutilsIsElf      (const char* fileName);
+bool     fileutilsLoadElf    (const char* fileName, uint8_t* mem, uint64_t memSize, uint32_t* entry);
+bool     fileutilsLoadIntelHex(const char* fileName, uint8_t* mem, uint64_t memSize, uint32_t base, uint32_t* entry);
+bool     fileutilsLoadMemHex (const char* fileName, uint8_t* mem, uint64_t memSize, uint32_t base, uint32_t wordBytes);
+bool     fileutilsLoadProgram(const char* fileName, fileutils_format_t format, uint8_t* mem, uint64_t memSize, uint32_t loadAddress, uint32_t* entry);
+fileutils_format_t fileutilsFormatFromName(const char* name);
 bool     fileutilsWriteBinary(const char* fileName, const uint8_t* mem, size_t memSize);
 
 #endif // FILEUTILS_H
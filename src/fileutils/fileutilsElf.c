@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "fileutils.h"
+
+/*
+Loader of statically linked ELF32 RISC-V executables. Each PT_LOAD segment is placed at its virtual address in guest
+memory. Whole pages of a segment are mapped copy-on-write from the file when the file offset and the virtual address
+agree modulo the page size, as linkers lay them out. Partial pages at the segment ends may be shared with another
+segment, so they are copied instead. The zero-initialised part of a segment, e.g. .bss, is left to the untouched
+guest memory pages, which read as zero until first touched.
+*/
+
+/*** Static function prototypes ***/
+static bool readAt(int fd, void* buf, size_t size, uint64_t offset);
+static bool checkHeader(const Elf32_Ehdr* header, uint64_t memSize);
+static bool loadSegment(int fd, const Elf32_Phdr* segment, uint8_t* mem, uint64_t memSize);
+
+/* Returns true if fileName can be opened and starts with the ELF magic number */
+bool fileutilsIsElf(const char* fileName)
+{
+    unsigned char ident[SELFMAG];
+    int fd;
+    bool isElf;
+
+    if ( strcmp(fileName, FILEUTILS_STDIN_NAME) == 0 || (fd = open(fileName, O_RDONLY)) < 0 )
+    {
+        return false;   // Standard input is only read as a flat binary, and failing opens are reported by the loader
+    }
+    isElf = readAt(fd, ident, sizeof(ident), 0) && memcmp(ident, ELFMAG, SELFMAG) == 0;
+    close(fd);
+
+    return isElf;
+}
+
+/* Places the PT_LOAD segments of an ELF32 RISC-V executable in already reserved, page aligned memory and sets entry
+   to its entry point. Returns false on failure. */
+bool fileutilsLoadElf(const char* fileName, uint8_t* mem, uint64_t memSize, uint32_t* entry)
+{
+    Elf32_Ehdr header;
+    Elf32_Phdr segment;
+    bool retVal = true;
+    int fd;
+
+    if ( (fd = open(fileName, O_RDONLY)) < 0 )
+    {
+        perror("fileutils error: Failed opening inputfile");
+        return false;
+    }
+    if ( !readAt(fd, &header, sizeof(header), 0) || !checkHeader(&header, memSize) )
+    {
+        close(fd);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.e_phnum && retVal; i++)
+    {
+        retVal = readAt(fd, &segment, sizeof(segment), header.e_phoff + (uint64_t) i * header.e_phentsize);
+        if (retVal && segment.p_type == PT_LOAD)
+        {
+            retVal = loadSegment(fd, &segment, mem, memSize);
+        }
+    }
+    if (retVal)
+    {
+        *entry = header.e_entry;
+    }
+    close(fd); // Mappings stay valid
+
+    return retVal;
+}
+
+bool readAt(int fd, void* buf, size_t size, uint64_t offset)
+{
+    ssize_t n;
+
+    while (size > 0)
+    {
+        if ( (n = pread(fd, buf, size, (off_t) offset)) <= 0 )
+        {
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "fileutils error: ELF file truncated or unreadable\n");
+            return false;
+        }
+        buf     = (uint8_t*) buf + n;
+        size   -= (size_t) n;
+        offset += (uint64_t) n;
+    }
+    return true;
+}
+
+bool checkHeader(const Elf32_Ehdr* header, uint64_t memSize)
+{
+    if ( memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 || header->e_ident[EI_CLASS] != ELFCLASS32 ||
+         header->e_ident[EI_DATA] != ELFDATA2LSB )
+    {
+        fprintf(stderr, "fileutils error: Not a little endian ELF32 file\n");
+    }
+    else if (header->e_machine != EM_RISCV || header->e_type != ET_EXEC)
+    {
+        fprintf(stderr, "fileutils error: ELF file is not a RISC-V executable\n");
+    }
+    else if (header->e_phentsize != sizeof(Elf32_Phdr))
+    {
+        fprintf(stderr, "fileutils error: Unexpected ELF program header size of %u B\n", header->e_phentsize);
+    }
+    else if (header->e_entry >= memSize || header->e_entry % 4 != 0)
+    {
+        fprintf(stderr, "fileutils error: ELF entry point 0x%08x outside memory or misaligned\n", header->e_entry);
+    }
+    else
+    {
+        return true;
+    }
+    return false;
+}
+
+/* Maps the whole pages of the file part of a segment and copies its partial end pages */
+bool loadSegment(int fd, const Elf32_Phdr* segment, uint8_t* mem, uint64_t memSize)
+{
+    uint64_t pageSize = (uint64_t) sysconf(_SC_PAGESIZE);
+    uint64_t start    = segment->p_vaddr;
+    uint64_t end      = start + segment->p_filesz;
+    uint64_t mapStart = (start + pageSize - 1) & ~(pageSize - 1);
+    uint64_t mapEnd   = end & ~(pageSize - 1);
+    uint64_t offset   = segment->p_offset;
+    bool     mappable = mapStart < mapEnd && (start - offset) % pageSize == 0;  // Wraps harmlessly for offset > start
+
+    if (segment->p_filesz > segment->p_memsz || start + segment->p_memsz > memSize)
+    {
+        fprintf(stderr, "fileutils error: ELF segment at 0x%08x of %u B does not fit in memory of %" PRIu64 " B\n",
+                segment->p_vaddr, segment->p_memsz, memSize);
+        return false;
+    }
+
+    if (mappable && mmap(mem + mapStart, mapEnd - mapStart, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd,
+                         (off_t) (offset + mapStart - start)) == MAP_FAILED)
+    {
+        // A failed fixed mapping may have removed the memory it was to replace, so zeroed pages are mapped back
+        if (mmap(mem + mapStart, mapEnd - mapStart, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0) == MAP_FAILED)
+        {
+            perror("fileutils error: Failed to restore memory after mapping ELF segment");
+            return false;
+        }
+        mappable = false;
+    }
+
+    if (mappable)
+    {
+        return readAt(fd, mem + start, mapStart - start, offset) &&
+               readAt(fd, mem + mapEnd, end - mapEnd, offset + mapEnd - start);
+    }
+    return readAt(fd, mem + start, end - start, offset);
+}
@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "fileutils.h"
+
+/*
+Loaders of the text images produced by hardware flows, Intel HEX and Verilog $readmemh. Both parse the whole image
+in a single pass over a read-only mapping of the file and write data straight into guest memory, so nothing is
+allocated per line or record. Inputs that cannot be mapped, e.g. standard input, are first read into one buffer.
+*/
+
+#define TEXT_CHUNK_BYTES    ( 1048576 ) // Initial buffer size and growth when reading text that cannot be mapped
+
+typedef struct text_t
+{
+    const char* start;
+    const char* end;
+    size_t      size;   // Bytes mapped or allocated
+    bool        mapped;
+} text_t;
+
+/* Hex digit values plus one, so all other characters are 0 */
+static const uint8_t hexDigits[256] = {
+    ['0'] = 1,  ['1'] = 2,  ['2'] = 3,  ['3'] = 4,  ['4'] = 5,  ['5'] = 6,  ['6'] = 7,  ['7'] = 8,  ['8'] = 9,  ['9'] = 10,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+/*** Static function prototypes ***/
+static bool openText(const char* fileName, text_t* text);
+static void closeText(text_t* text);
+static bool readText(int fd, text_t* text);
+static int  hexValue(char c);
+static bool hexByte(const char** pos, const char* end, uint8_t* value);
+static bool fitsMemory(uint64_t memSize, uint64_t adr, uint32_t size, uint32_t line);
+
+/* Loads an Intel HEX image, placing each data record at base plus its address. entry is set from a start address
+   record if the image has one, and is left unchanged otherwise. Returns false on failure. */
+bool fileutilsLoadIntelHex(const char* fileName, uint8_t* mem, uint64_t memSize, uint32_t base, uint32_t* entry)
+{
+    text_t text;
+    const char* pos;
+    const char* data;       // Data bytes of the current record
+    uint32_t line = 1;
+    uint32_t upper = 0;     // Address set by the last extended segment or linear address record
+    uint32_t value;
+    uint8_t  count, adrHigh, adrLow, type, byte, sum;
+    uint64_t adr;
+    bool     done = false;
+    bool     retVal = true;
+
+    if (!openText(fileName, &text))
+    {
+        return false;
+    }
+
+    for (pos = text.start; pos < text.end && !done && retVal; )
+    {
+        if (*pos == '\n' || *pos == '\r' || *pos == ' ' || *pos == '\t')
+        {
+            line += (*pos++ == '\n');
+            continue;
+        }
+        if (*pos++ != ':' || !hexByte(&pos, text.end, &count) || !hexByte(&pos, text.end, &adrHigh) ||
+            !hexByte(&pos, text.end, &adrLow) || !hexByte(&pos, text.end, &type))
+        {
+            fprintf(stderr, "fileutils error: Malformed Intel HEX record on line %" PRIu32 "\n", line);
+            retVal = false;
+            break;
+        }
+        // Checksum the record before storing its data, which is then read again from the text
+        data  = pos;
+        sum   = count + adrHigh + adrLow + type;
+        value = 0;
+        for (uint32_t i = 0; i < count && (retVal = hexByte(&pos, text.end, &byte)); i++)
+        {
+            sum  += byte;
+            value = value << 8 | byte;  // Big endian address and start record fields
+        }
+        if (!retVal || !hexByte(&pos, text.end, &byte) || (uint8_t) (sum + byte) != 0)
+        {
+            fprintf(stderr, "fileutils error: Malformed Intel HEX record or bad checksum on line %" PRIu32 "\n", line);
+            retVal = false;
+            break;
+        }
+        if ( ((type == 0x02 || type == 0x04) && count != 2) || ((type == 0x03 || type == 0x05) && count != 4) )
+        {
+            fprintf(stderr, "fileutils error: Intel HEX record type %02x of %" PRIu8 " bytes on line %" PRIu32 "\n", type, count, line);
+            retVal = false;
+            break;
+        }
+
+        switch (type)
+        {
+        case 0x00:  // Data
+            adr = (uint64_t) base + upper + ((uint32_t) adrHigh << 8 | adrLow);
+            if ( (retVal = fitsMemory(memSize, adr, count, line)) )
+            {
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    hexByte(&data, text.end, &mem[adr + i]);
+                }
+            }
+            break;
+        case 0x01:  // End of file
+            done = true;
+            break;
+        case 0x02:  // Extended segment address
+            upper = (value & 0xffff) << 4;
+            break;
+        case 0x03:  // Start segment address, CS:IP
+            *entry = ((value >> 16) << 4) + (value & 0xffff);
+            break;
+        case 0x04:  // Extended linear address
+            upper = (value & 0xffff) << 16;
+            break;
+        case 0x05:  // Start linear address
+            *entry = value;
+            break;
+        default:
+            fprintf(stderr, "fileutils error: Unknown Intel HEX record type %02x on line %" PRIu32 "\n", type, line);
+            retVal = false;
+            break;
+        }
+    }
+    if (retVal && !done)
+    {
+        fprintf(stderr, "fileutils error: Intel HEX image without end of file record\n");
+        retVal = false;
+    }
+    closeText(&text);
+
+    return retVal;
+}
+
+/* Loads a Verilog $readmemh image of wordBytes wide words, stored little endian from base. Words are separated by
+   white space and may contain underscores, @ followed by a hex word address moves to that address, and // and
+   block comments are skipped. Returns false on failure. */
+bool fileutilsLoadMemHex(const char* fileName, uint8_t* mem, uint64_t memSize, uint32_t base, uint32_t wordBytes)
+{
+    text_t text;
+    const char* pos;
+    uint32_t line = 1;
+    uint64_t wordAdr = 0;
+    uint64_t value;
+    uint32_t digits;
+    bool     isAdr;
+    bool     retVal = true;
+    int      digit;
+
+    if (!openText(fileName, &text))
+    {
+        return false;
+    }
+
+    for (pos = text.start; pos < text.end && retVal; )
+    {
+        if (*pos == '\n' || *pos == '\r' || *pos == ' ' || *pos == '\t')
+        {
+            line += (*pos++ == '\n');
+            continue;
+        }
+        if (*pos == '/' && pos + 1 < text.end && pos[1] == '/')
+        {
+            while (pos < text.end && *pos != '\n')
+            {
+                pos++;
+            }
+            continue;
+        }
+        if (*pos == '/' && pos + 1 < text.end && pos[1] == '*')
+        {
+            for (pos += 2; pos < text.end && !(*pos == '*' && pos + 1 < text.end && pos[1] == '/'); pos++)
+            {
+                line += (*pos == '\n');
+            }
+            pos += 2;
+            continue;
+        }
+
+        isAdr  = (*pos == '@');
+        pos   += isAdr;
+        value  = 0;
+        digits = 0;
+        for ( ; pos < text.end && ( (digit = hexValue(*pos)) >= 0 || *pos == '_' ); pos++)
+        {
+            if (digit >= 0)
+            {
+                value = value << 4 | (uint64_t) digit;
+                digits++;
+            }
+        }
+        if (digits == 0 || digits > (isAdr ? 8 : 2 * wordBytes) ||
+            (pos < text.end && *pos != '\n' && *pos != '\r' && *pos != ' ' && *pos != '\t' && *pos != '/'))
+        {
+            fprintf(stderr, "fileutils error: Malformed $readmemh word on line %" PRIu32 "\n", line);
+            retVal = false;
+        }
+        else if (isAdr)
+        {
+            wordAdr = value;
+        }
+        else if ( (retVal = fitsMemory(memSize, base + wordAdr * wordBytes, wordBytes, line)) )
+        {
+            for (uint32_t i = 0; i < wordBytes; i++)
+            {
+                mem[base + wordAdr * wordBytes + i] = (uint8_t) (value >> (8 * i));
+            }
+            wordAdr++;
+        }
+    }
+    closeText(&text);
+
+    return retVal;
+}
+
+bool openText(const char* fileName, text_t* text)
+{
+    struct stat status;
+    void* adr = MAP_FAILED;
+    int fd;
+    bool retVal = true;
+
+    if (strcmp(fileName, FILEUTILS_STDIN_NAME) == 0)
+    {
+        fd = dup(STDIN_FILENO); // Closed like an opened file
+    }
+    else
+    {
+        fd = open(fileName, O_RDONLY);
+    }
+    if (fd < 0)
+    {
+        perror("fileutils error: Failed opening inputfile");
+        return false;
+    }
+
+    if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0 &&
+        (adr = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED)
+    {
+        text->start  = adr;
+        text->size   = (size_t) status.st_size;
+        text->end    = text->start + text->size;
+        text->mapped = true;
+    }
+    else
+    {
+        retVal = readText(fd, text);
+    }
+    close(fd); // A mapping stays valid
+
+    return retVal;
+}
+
+void closeText(text_t* text)
+{
+    if (text->mapped)
+    {
+        munmap((void*) text->start, text->size);
+    }
+    else
+    {
+        free((void*) text->start);
+    }
+}
+
+/* Reads all of fd into a buffer grown by doubling */
+bool readText(int fd, text_t* text)
+{
+    char* buf = NULL;
+    char* grown;
+    size_t size = 0;
+    size_t capacity = 0;
+    ssize_t n = 1;
+
+    while (n > 0 || (n < 0 && errno == EINTR))
+    {
+        if (size == capacity)
+        {
+            capacity = (capacity == 0) ? TEXT_CHUNK_BYTES : 2 * capacity;
+            if ( (grown = realloc(buf, capacity)) == NULL )
+            {
+                fprintf(stderr, "fileutils error: Failed to allocate memory for reading image\n");
+                free(buf);
+                return false;
+            }
+            buf = grown;
+        }
+        if ( (n = read(fd, buf + size, capacity - size)) > 0 )
+        {
+            size += (size_t) n;
+        }
+    }
+    if (n < 0)
+    {
+        perror("fileutils error: Input not read to end");
+        free(buf);
+        return false;
+    }
+
+    text->start  = buf;
+    text->end    = buf + size;
+    text->size   = capacity;
+    text->mapped = false;
+    return true;
+}
+
+/* Returns the value of a hex digit, or -1 for any other character */
+int hexValue(char c)
+{
+    return hexDigits[(unsigned char) c] - 1;
+}
+
+bool hexByte(const char** pos, const char* end, uint8_t* value)
+{
+    int high, low;
+
+    if (*pos + 2 > end || (high = hexValue((*pos)[0])) < 0 || (low = hexValue((*pos)[1])) < 0)
+    {
+        return false;
+    }
+    *value = (uint8_t) (high << 4 | low);
+    *pos  += 2;
+    return true;
+}
+
+bool fitsMemory(uint64_t memSize, uint64_t adr, uint32_t size, uint32_t line)
+{
+    if (adr + size > memSize)
+    {
+        fprintf(stderr, "fileutils error: Image data at 0x%08" PRIx64 " on line %" PRIu32 " beyond memory of %" PRIu64 " B\n",
+                adr, line, memSize);
+        return false;
+    }
+    return true;
+}
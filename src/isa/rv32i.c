@@ -1,164 +1,81 @@
 #include "rv32i.h"
+#include "rv32iInline.h"    // Out-of-line definitions of the hot path helpers
 #include <assert.h>
 #include <stdio.h>
 
-rv32i_instruct_t rv32iDecodeInstructType(int32_t instruct)
+/* Index into rv32iDecodeTable from opcode[6:2], funct3 and bit 30 */
+#define RV32I_DECODE_INDEX(instruct) ( (((uint32_t) (instruct) >>  2) & 0b000011111) | \
+                                       (((uint32_t) (instruct) >>  7) & 0b011100000) | \
+                                       (((uint32_t) (instruct) >> 22) & 0b100000000) )
+
+typedef struct rv32i_decode_entry_t
 {
-    uint8_t opcode, funct3, funct7;
-    uint16_t funct12;
+    uint32_t mask;      // Fixed bits of the encoding
+    uint32_t match;     // Value of the fixed bits
+    int8_t   type;
+    int8_t   format;
+} rv32i_decode_entry_t;
 
-    opcode  = rv32iGetOpcode(instruct);
-    funct3  = rv32iGetFunct3(instruct);
-    funct7  = rv32iGetFunct7(instruct);
-    funct12 = rv32iGetFunct12(instruct);
+#include "rv32iDecodeTable.h"   // Generated from rv32i.def by rv32iGenTables.c
 
-    switch (opcode)
+/*** Static function prototypes ***/
+static inline int32_t formatImmediate(int32_t instruct, enum rv32i_opcodeTypes_t format);
+
+rv32i_decoded_t rv32iDecode(int32_t instruct)
+{
+    const rv32i_decode_entry_t* entry = &rv32iDecodeTable[RV32I_DECODE_INDEX(instruct)];
+    rv32i_decoded_t decoded = {
+        .rd  = (instruct >>  7) & 0b11111,
+        .rs1 = (instruct >> 15) & 0b11111,
+        .rs2 = (instruct >> 20) & 0b11111,
+    };
+
+    if ( ((uint32_t) instruct & entry->mask) == entry->match )
     {
-    case RV32I_OPCODE_ALU:
-        switch (funct3)
-        {
-        case 0b000:
-            switch (funct7)
-            {
-            case 0b0000000:
-                return RV32I_ADD;
-            case 0b0100000:
-                return RV32I_SUB;
-            default:
-                return RV32I_NOT_SUPPORTED;
-            }
-        case 0b001:
-            return RV32I_SLL;
-        case 0b010:
-            return RV32I_SLT;
-        case 0b011:
-            return RV32I_SLTU;
-        case 0b100:
-            return RV32I_XOR;
-        case 0b101:
-            switch (funct7)
-            {
-            case 0b0000000:
-                return RV32I_SRL;
-            case 0b0100000:
-                return RV32I_SRA;
-            default:
-                return RV32I_NOT_SUPPORTED;
-            }
-        case 0b110:
-            return RV32I_OR;
-        case 0b111:
-            return RV32I_AND;
-        default:
-            assert(0); // This condition should be unreachable.
-            return RV32I_NOT_SUPPORTED;
-        }
-        break;
-    case RV32I_OPCODE_ALU_IMM:
-        switch (funct3)
-        {
-        case 0b000:
-            return RV32I_ADDI;
-        case 0b010:
-            return RV32I_SLTI;
-        case 0b011:
-            return RV32I_SLTIU;
-        case 0b100:
-            return RV32I_XORI;
-        case 0b110:
-            return RV32I_ORI;
-        case 0b111:
-            return RV32I_ANDI;
-        case 0b001:
-            return RV32I_SLLI;
-        case 0b101:
-            switch (funct7)
-            {
-            case 0b0000000:
-                return RV32I_SRLI;
-            case 0b0100000:
-                return RV32I_SRAI;
-            default:
-                return RV32I_NOT_SUPPORTED;
-            }
-        default:
-            assert(0); // This condition should be unreachable.
-            return RV32I_NOT_SUPPORTED;
-        }
-    case RV32I_OPCODE_AUIPC:
-        return RV32I_AUIPC;
-    case RV32I_OPCODE_BRANCH:
-        switch (funct3)
-        {
-        case 0b000:
-            return RV32I_BEQ;
-        case 0b001:
-            return RV32I_BNE;
-        case 0b100:
-            return RV32I_BLT;
-        case 0b101:
-            return RV32I_BGE;
-        case 0b110:
-            return RV32I_BLTU;
-        case 0b111:
-            return RV32I_BGEU;
-        default:
-            return RV32I_NOT_SUPPORTED;
-        }
-    case RV32I_OPCODE_ENV:
-        switch (funct12)
-        {
-        case 0b000000000000:
-            return RV32I_ECALL;
-        default:
-            return RV32I_NOT_SUPPORTED;
-        }
-    case RV32I_OPCODE_FEN_PAUS:
-        return RV32I_NOT_SUPPORTED;
-    case RV32I_OPCODE_JAL:
-        return RV32I_JAL;
-    case RV32I_OPCODE_JALR:
-        return RV32I_JALR;
-    case RV32I_OPCODE_LOAD:
-        switch (funct3)
-        {
-        case 0b000:
-            return RV32I_LB;
-        case 0b001:
-            return RV32I_LH;
-        case 0b010:
-            return RV32I_LW;
-        case 0b100:
-            return RV32I_LBU;
-        case 0b101:
-            return RV32I_LHU;
-        default:
-            return RV32I_NOT_SUPPORTED;
-        }
-    case RV32I_OPCODE_LUI:
-        return RV32I_LUI;
-    case RV32I_OPCODE_STORE:
-        switch (funct3)
-        {
-        case 0b000:
-            return RV32I_SB;
-        case 0b001:
-            return RV32I_SH;
-        case 0b010:
-            return RV32I_SW;
-        default:
-            return RV32I_NOT_SUPPORTED;
-        }
-    default:
-        return RV32I_NOT_SUPPORTED;
+        decoded.type   = entry->type;
+        decoded.format = entry->format;
+    }
+    else
+    {
+        decoded.type   = RV32I_NOT_SUPPORTED;
+        decoded.format = RV32I_OPCODE_TYPE_UNKNOWN;
     }
+    decoded.imm = formatImmediate(instruct, decoded.format);
+
+    return decoded;
+}
+
+rv32i_instruct_t rv32iDecodeInstructType(int32_t instruct)
+{
+    const rv32i_decode_entry_t* entry = &rv32iDecodeTable[RV32I_DECODE_INDEX(instruct)];
+
+    return ( ((uint32_t) instruct & entry->mask) == entry->match ) ? entry->type : RV32I_NOT_SUPPORTED;
 }
 
 int32_t rv32iGenerateImmediate(int32_t instruct)
+{
+    return formatImmediate(instruct, rv32iOpcodeToOpcodeType(rv32iGetOpcode(instruct)));
+}
+
+const char* rv32iInstructName(int8_t type)
+{
+    static const char* names[RV32I_INSTRUCT_COUNT] = {
+#define RV32I_INSTRUCT(name, format, opcode, funct3, funct7, funct12) [RV32I_##name] = #name,
+#include "rv32i.def"
+#undef RV32I_INSTRUCT
+    };
+
+    if (type < 0 || type >= RV32I_INSTRUCT_COUNT)
+    {
+        return "NOT_SUPPORTED";
+    }
+    return names[type];
+}
+
+int32_t formatImmediate(int32_t instruct, enum rv32i_opcodeTypes_t format)
 {
     int32_t imm = 0;
-    uint8_t opcode = rv32iGetOpcode(instruct);
-    switch (rv32iOpcodeToOpcodeType(opcode))
+    switch (format)
     {
     case RV32I_OPCODE_TYPE_I:
         imm  = (instruct >> 20);
@@ -197,58 +114,6 @@ int32_t rv32iGenerateImmediate(int32_t instruct)
     return imm;
 }
 
-uint16_t rv32iGetFunct12(int32_t instruct)
-{
-    return (instruct >> 20) & 0b00000000000000000000111111111111;
-}
-
-uint8_t rv32iGetFunct3(int32_t instruct)
-{
-    return (instruct >> 12) & 0b00000000000000000000000000000111;
-}
-
-uint8_t rv32iGetFunct7(int32_t instruct)
-{
-    return (instruct >> 25) & 0b00000000000000000000000001111111;
-}
-
-uint8_t rv32iGetOpcode(int32_t instruct)
-{
-    return (instruct >>  0) & 0b00000000000000000000000001111111;
-}
-
-uint8_t rv32iGetRd(int32_t instruct)
-{
-    return (instruct >>  7) & 0b00000000000000000000000000011111;
-}
-
-uint8_t rv32iGetRs1(int32_t instruct)
-{
-    return (instruct >> 15) & 0b00000000000000000000000000011111;
-}
-
-uint8_t rv32iGetRs2(int32_t instruct)
-{
-    return (instruct >> 20) & 0b00000000000000000000000000011111;
-}
-
-int32_t rv32iLoadByte(uint8_t *adr)
-{
-    return *adr;
-}
-
-int32_t rv32iLoadHalfWord(uint8_t *adr)
-{
-    // TODO: Make solution for both endianness - Currently little endian is assumed
-    return ( (int16_t) *adr | ( (int16_t) *(adr+1) << 8 ) );
-}
-
-int32_t rv32iLoadWord(uint8_t *adr)
-{
-    // TODO: Make solution for both endianness - Currently little endian is assumed
-    return ( (int16_t) *adr | ( (int16_t) *(adr+1) << 8 ) | ( (int16_t) *(adr+2) << 16 ) | ( (int16_t) *(adr+3) << 24 ) );
-}
-
 rv32i_opcodeTypes_t rv32iOpcodeToOpcodeType(uint8_t opcode)
 {
     switch (opcode)
@@ -273,55 +138,3 @@ rv32i_opcodeTypes_t rv32iOpcodeToOpcodeType(uint8_t opcode)
         return RV32I_OPCODE_TYPE_UNKNOWN;
     }
 }
-
-int32_t rv32iSignExtentByte(uint8_t input)
-{
-    uint8_t signBit = input >> 7;
-
-    if (signBit)
-    {
-        return (0b11111111111111111111111100000000 | input);
-    }
-    else
-    {
-        return input;
-    }
-}
-
-int32_t rv32iSignExtentHalfWord(uint16_t input)
-{
-    uint16_t signBit = input >> 15;
-
-    if (signBit)
-    {
-        return (0b11111111111111110000000000000000 | input);
-    }
-    else
-    {
-        return input;
-    }
-}
-
-void rv32iStoreByte(uint8_t *adr, uint8_t value)
-{
-    *adr = value;
-    return;
-}
-
-void rv32iStoreHalfWord(uint8_t *adr, uint16_t value)
-{
-    // TODO: Make solution for both endianness - Currently little endian is assumed
-    *(adr  ) = value;
-    *(adr+1) = value >> 8;
-    return;
-}
-
-void rv32iStoreWord(uint8_t *adr, uint32_t value)
-{
-    // TODO: Make solution for both endianness - Currently little endian is assumed
-    *(adr  ) = value;
-    *(adr+1) = value >>  8;
-    *(adr+2) = value >> 16;
-    *(adr+3) = value >> 24;
-    return;
-}
@@ -31,31 +31,55 @@ typedef enum rv32i_instruct_t
     RV32I_SRLI, RV32I_SUB, RV32I_SW, RV32I_XOR, RV32I_XORI,
 } rv32i_instruct_t;
 
+#define RV32I_INSTRUCT_COUNT    (RV32I_XORI + 1)    // Number of supported instructions
+
 typedef enum rv32i_opcodeTypes_t
 {
     RV32I_OPCODE_TYPE_UNKNOWN = -1, RV32I_OPCODE_TYPE_R = 0, RV32I_OPCODE_TYPE_I, RV32I_OPCODE_TYPE_S,
     RV32I_OPCODE_TYPE_B, RV32I_OPCODE_TYPE_U, RV32I_OPCODE_TYPE_J
 } rv32i_opcodeTypes_t;
 
+/* Hot path helpers from rv32iInline.h are static inline when compiling with RV32I_USE_INLINE */
+#ifdef RV32I_USE_INLINE
+#define RV32I_API static inline
+#else
+#define RV32I_API
+#endif
+
+/* All fields of an instruction, produced in a single pass by rv32iDecode */
+typedef struct rv32i_decoded_t
+{
+    int32_t imm;        // Immediate as given by rv32iGenerateImmediate for supported instructions
+    int8_t  type;       // enum rv32i_instruct_t
+    int8_t  format;     // enum rv32i_opcodeTypes_t, RV32I_OPCODE_TYPE_UNKNOWN when not supported
+    uint8_t rd;
+    uint8_t rs1;
+    uint8_t rs2;
+} rv32i_decoded_t;
 
-enum rv32i_instruct_t rv32iDecodeInstructType(int32_t instruct);
-int32_t  rv32iGenerateImmediate(int32_t instruct);
-uint16_t rv32iGetFunct12(int32_t instruct);
-uint8_t  rv32iGetFunct3 (int32_t instruct);
-uint8_t  rv32iGetFunct7 (int32_t instruct);
-uint8_t  rv32iGetOpcode (int32_t instruct);
-uint8_t  rv32iGetRd (int32_t instruct);
-uint8_t  rv32iGetRs1(int32_t instruct);
-uint8_t  rv32iGetRs2(int32_t instruct);
-int32_t  rv32iLoadByte    (uint8_t* adr);
-int32_t  rv32iLoadHalfWord(uint8_t* adr);
-int32_t  rv32iLoadWord    (uint8_t* adr);
-enum rv32i_opcodeTypes_t rv32iOpcodeToOpcodeType (uint8_t opcode);
-int32_t  rv32iSignExtentByte    (uint8_t  input);
-int32_t  rv32iSignExtentHalfWord(uint16_t input);
-void     rv32iStoreByte    (uint8_t* adr, uint8_t  value);
-void     rv32iStoreHalfWord(uint8_t* adr, uint16_t value);
-void     rv32iStoreWord    (uint8_t* adr, uint32_t value);
+          rv32i_decoded_t rv32iDecode(int32_t instruct);
+          enum rv32i_instruct_t rv32iDecodeInstructType(int32_t instruct);
+          int32_t  rv32iGenerateImmediate(int32_t instruct);
+          const char* rv32iInstructName(int8_t type);
+RV32I_API uint16_t rv32iGetFunct12(int32_t instruct);
+RV32I_API uint8_t  rv32iGetFunct3 (int32_t instruct);
+RV32I_API uint8_t  rv32iGetFunct7 (int32_t instruct);
+RV32I_API uint8_t  rv32iGetOpcode (int32_t instruct);
+RV32I_API uint8_t  rv32iGetRd (int32_t instruct);
+RV32I_API uint8_t  rv32iGetRs1(int32_t instruct);
+RV32I_API uint8_t  rv32iGetRs2(int32_t instruct);
+RV32I_API int32_t  rv32iLoadByte    (uint8_t* adr);
+RV32I_API int32_t  rv32iLoadHalfWord(uint8_t* adr);
+RV32I_API int32_t  rv32iLoadWord    (uint8_t* adr);
+          enum rv32i_opcodeTypes_t rv32iOpcodeToOpcodeType (uint8_t opcode);
+RV32I_API int32_t  rv32iSignExtentByte    (uint8_t  input);
+RV32I_API int32_t  rv32iSignExtentHalfWord(uint16_t input);
+RV32I_API void     rv32iStoreByte    (uint8_t* adr, uint8_t  value);
+RV32I_API void     rv32iStoreHalfWord(uint8_t* adr, uint16_t value);
+RV32I_API void     rv32iStoreWord    (uint8_t* adr, uint32_t value);
 
+#ifdef RV32I_USE_INLINE
+#include "rv32iInline.h"
+#endif
 
 #endif //RV32I_H
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "rv32i.h"
+
+/*
+Build time generator for the instruction decode table used by rv32iDecodeInstructType. The table is indexed by
+opcode[6:2], funct3 and bit 30 (the bit telling SUB from ADD and SRA from SRL), see RV32I_DECODE_INDEX in rv32i.c.
+Each entry holds the only instruction possible for that index together with a mask and match value for the
+remaining fixed bits of the encoding, so decoding costs one table load and one compare. Unused indexes never match.
+The entry also holds the instruction format, which rv32iDecode uses to extract the immediate without a second
+lookup of the opcode.
+
+Usage: rv32iGenTables <output header>
+*/
+
+#define RV32I_ANY           (-1)
+#define DECODE_TABLE_SIZE   (1 << 9)
+
+typedef struct description_t
+{
+    const char* name;
+    const char* format;
+    int8_t      type;
+    int32_t     opcode;
+    int32_t     funct3;
+    int32_t     funct7;
+    int32_t     funct12;
+} description_t;
+
+static const description_t descriptions[] = {
+#define RV32I_INSTRUCT(name, format, opcode, funct3, funct7, funct12) { #name, #format, RV32I_##name, opcode, funct3, funct7, funct12 },
+#include "rv32i.def"
+#undef RV32I_INSTRUCT
+};
+
+int main(int argc, char* argv[])
+{
+    FILE* out;
+    int   retVal = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <output header>\n", argv[0]);
+        return 1;
+    }
+    if ( (out = fopen(argv[1], "w")) == NULL )
+    {
+        perror("rv32iGenTables error: Unable to open output");
+        return 1;
+    }
+
+    fprintf(out, "/* Generated by rv32iGenTables.c from rv32i.def, do not edit. */\n");
+    fprintf(out, "static const rv32i_decode_entry_t rv32iDecodeTable[%d] = {\n", DECODE_TABLE_SIZE);
+    for (uint32_t index = 0; index < DECODE_TABLE_SIZE; index++)
+    {
+        uint32_t opcode = ((index & 0b11111) << 2) | 0b11;
+        uint32_t funct3 = (index >> 5) & 0b111;
+        uint32_t bit30  = (index >> 8) & 0b1;
+        const description_t* found = NULL;
+        uint32_t mask  = 0;
+        uint32_t match = 0;
+
+        for (size_t i = 0; i < sizeof(descriptions)/sizeof(descriptions[0]); i++)
+        {
+            const description_t* d = &descriptions[i];
+            if ( (uint32_t) d->opcode != opcode ||
+                 (d->funct3  != RV32I_ANY && (uint32_t) d->funct3 != funct3) ||
+                 (d->funct7  != RV32I_ANY && (uint32_t) ((d->funct7 >> 5) & 0b1) != bit30) ||
+                 (d->funct12 != RV32I_ANY && (uint32_t) ((d->funct12 >> 10) & 0b1) != bit30) )
+            {
+                continue;
+            }
+            if (found != NULL)
+            {
+                fprintf(stderr, "rv32iGenTables error: %s and %s share decode index %u\n", found->name, d->name, index);
+                retVal = 1;
+            }
+            found = d;
+            mask  = 0b1111111;
+            match = opcode;
+            if (d->funct3 != RV32I_ANY)
+            {
+                mask  |= 0b111 << 12;
+                match |= (uint32_t) d->funct3 << 12;
+            }
+            if (d->funct7 != RV32I_ANY)
+            {
+                mask  |= (uint32_t) 0b1111111 << 25;
+                match |= (uint32_t) d->funct7 << 25;
+            }
+            if (d->funct12 != RV32I_ANY)
+            {
+                mask  |= (uint32_t) 0b111111111111 << 20;
+                match |= (uint32_t) d->funct12 << 20;
+            }
+        }
+
+        if (found != NULL)
+        {
+            fprintf(out, "    [%3u] = { 0x%08x, 0x%08x, RV32I_%s, RV32I_OPCODE_TYPE_%s },\n", index, mask, match, found->name, found->format);
+        }
+        else
+        {
+            fprintf(out, "    [%3u] = { 0x00000000, 0xffffffff, RV32I_NOT_SUPPORTED, RV32I_OPCODE_TYPE_UNKNOWN },\n", index); // Never matches
+        }
+    }
+    fprintf(out, "};\n");
+
+    if (fclose(out) != 0)
+    {
+        perror("rv32iGenTables error: Unable to write output");
+        retVal = 1;
+    }
+    return retVal;
+}
@@ -0,0 +1,128 @@
+#ifndef RV32I_INLINE_H
+#define RV32I_INLINE_H
+#include <stdint.h>
+#include <string.h> // Supplies memcpy()
+
+/*
+Definitions of the small rv32i helpers used on the hot path of every simulator. Translation units compiled with
+RV32I_USE_INLINE get them as static inline functions through rv32i.h, so they inline without LTO across the rv32i
+library boundary. Otherwise only rv32i.c includes this file, providing the out-of-line library versions used by the
+tests. Do not include this file directly.
+
+Guest memory is little endian. Loads and stores are a single memcpy of the access size, which compilers turn into
+one native unaligned access, byte swapped on big endian hosts. The host byte order is resolved at compile time.
+*/
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define RV32I_LITTLE_ENDIAN16(value)    __builtin_bswap16(value)
+#define RV32I_LITTLE_ENDIAN32(value)    __builtin_bswap32(value)
+#else
+#define RV32I_LITTLE_ENDIAN16(value)    (value)
+#define RV32I_LITTLE_ENDIAN32(value)    (value)
+#endif
+
+RV32I_API uint16_t rv32iGetFunct12(int32_t instruct)
+{
+    return (instruct >> 20) & 0b00000000000000000000111111111111;
+}
+
+RV32I_API uint8_t rv32iGetFunct3(int32_t instruct)
+{
+    return (instruct >> 12) & 0b00000000000000000000000000000111;
+}
+
+RV32I_API uint8_t rv32iGetFunct7(int32_t instruct)
+{
+    return (instruct >> 25) & 0b00000000000000000000000001111111;
+}
+
+RV32I_API uint8_t rv32iGetOpcode(int32_t instruct)
+{
+    return (instruct >>  0) & 0b00000000000000000000000001111111;
+}
+
+RV32I_API uint8_t rv32iGetRd(int32_t instruct)
+{
+    return (instruct >>  7) & 0b00000000000000000000000000011111;
+}
+
+RV32I_API uint8_t rv32iGetRs1(int32_t instruct)
+{
+    return (instruct >> 15) & 0b00000000000000000000000000011111;
+}
+
+RV32I_API uint8_t rv32iGetRs2(int32_t instruct)
+{
+    return (instruct >> 20) & 0b00000000000000000000000000011111;
+}
+
+RV32I_API int32_t rv32iLoadByte(uint8_t *adr)
+{
+    return *adr;
+}
+
+RV32I_API int32_t rv32iLoadHalfWord(uint8_t *adr)
+{
+    uint16_t value;
+
+    memcpy(&value, adr, sizeof(value));
+    return RV32I_LITTLE_ENDIAN16(value);
+}
+
+RV32I_API int32_t rv32iLoadWord(uint8_t *adr)
+{
+    uint32_t value;
+
+    memcpy(&value, adr, sizeof(value));
+    return (int32_t) RV32I_LITTLE_ENDIAN32(value);
+}
+
+RV32I_API int32_t rv32iSignExtentByte(uint8_t input)
+{
+    uint8_t signBit = input >> 7;
+
+    if (signBit)
+    {
+        return (0b11111111111111111111111100000000 | input);
+    }
+    else
+    {
+        return input;
+    }
+}
+
+RV32I_API int32_t rv32iSignExtentHalfWord(uint16_t input)
+{
+    uint16_t signBit = input >> 15;
+
+    if (signBit)
+    {
+        return (0b11111111111111110000000000000000 | input);
+    }
+    else
+    {
+        return input;
+    }
+}
+
+RV32I_API void rv32iStoreByte(uint8_t *adr, uint8_t value)
+{
+    *adr = value;
+    return;
+}
+
+RV32I_API void rv32iStoreHalfWord(uint8_t *adr, uint16_t value)
+{
+    value = RV32I_LITTLE_ENDIAN16(value);
+    memcpy(adr, &value, sizeof(value));
+    return;
+}
+
+RV32I_API void rv32iStoreWord(uint8_t *adr, uint32_t value)
+{
+    value = RV32I_LITTLE_ENDIAN32(value);
+    memcpy(adr, &value, sizeof(value));
+    return;
+}
+
+#endif // RV32I_INLINE_H
@@ -1,22 +1,33 @@
 /*** Includes ***/
 #include <stdio.h>  // Supplies file access + print
 #include <stdint.h> // Suplies types, e.g. uint64_t
+#include <inttypes.h>
 #include <stdbool.h>
 #include <stdlib.h> // Suplies EXIT_FAILURE, EXIT_SUCCESS, exit()
+#include "batch.h"
 #include "cli.h"
 #include "fileutils.h"
-#include "simSoft.h"
+#include "guestMem.h"
+#include "sim.h"
+#include "snapshot.h"
 
 /*** Defines ***/
-#define PROGRAM_SIZE_BYTES          ( 1048576 ) // 1 MiB
-#define REGISTRY_FILE_SIZE_BYTES    ( 128 )     // 32 32-bit registers
+#define REGISTRY_FILE_SIZE_BYTES    ( SIM_REG_COUNT * 4 )   // 32 32-bit registers, the discard slot is not saved
+#define SNAPSHOT_FILE_NAME          "RiVIS.snap"            // Default of --snapshot-file
 
 
 int main(int argc, char *argv[])
 {
-    uint8_t* prog = NULL;
-    int32_t regFile[32] = {};
-    cli_options_t cliOptions = {0, NULL, NULL};
+    guest_mem_t mem = {};
+    sim_state_t state = {};
+    cli_options_t cliOptions = { .memSize = GUEST_MEM_DEFAULT_BYTES, .snapshotFileName = SNAPSHOT_FILE_NAME };
+    sim_engine_t engine;
+    fileutils_format_t format;
+    uint64_t snapshotAt;
+    uint32_t checkpoints = 0;
+    sim_options_t simOptions = {};
+    sim_stats_t stats = {};
+    sim_stats_t phase;
 
 
     // Handle command-line arguments
@@ -31,25 +42,145 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);     // Unexpected CLI invocation encountered
     }
 
-    // Read binary file to program memory
-    prog = fileutilsReadBinary(cliOptions.inFileName, PROGRAM_SIZE_BYTES);
-    if ( prog == NULL )
+    // Select execution engine
+    if ( (engine = simEngineFromName(cliOptions.engineName)) == SIM_ENGINE_UNKNOWN )
     {
+        fprintf(stderr, "RiVIS error: Unknown engine '%s'\n", cliOptions.engineName);
         exit(EXIT_FAILURE);
     }
+    if ( (format = fileutilsFormatFromName(cliOptions.formatName)) == FILEUTILS_FORMAT_UNKNOWN )
+    {
+        fprintf(stderr, "RiVIS error: Unknown input format '%s'\n", cliOptions.formatName);
+        exit(EXIT_FAILURE);
+    }
+    if ( cliOptions.verbosity && engine != SIM_ENGINE_SOFT )
+    {
+        fprintf(stderr, "RiVIS warning: Verbose tracing is only available with the soft engine\n");
+    }
+    if ( cliOptions.traceFileName != NULL && engine != SIM_ENGINE_SOFT )
+    {
+        fprintf(stderr, "RiVIS warning: Binary tracing is only available with the soft engine\n");
+    }
 
-    // Run program
-    int8_t res = simSoftRun(prog, PROGRAM_SIZE_BYTES, regFile, cliOptions.verbosity); // TODO: Evaluate return value
-    free(prog);
+    if ( cliOptions.batchFileName != NULL )
+    {
+        // Run every job of the manifest in this process instead of a single input, printing each as it finishes
+        batch_t batch;
+        batch_options_t batchOptions = { .engine = engine, .memSize = cliOptions.memSize, .format = format,
+                                         .loadAddress = cliOptions.loadAddress, .hasEntry = cliOptions.hasEntry,
+                                         .entry = cliOptions.entry, .threads = cliOptions.threads,
+                                         .slice = cliOptions.slice, .progress = stdout };
+        if ( cliOptions.snapshotAt != 0 || cliOptions.snapshotEvery != 0 || cliOptions.restoreFileName != NULL ||
+             cliOptions.outFileName != NULL )
+        {
+            fprintf(stderr, "RiVIS warning: -o and snapshots are ignored in batch mode, outputs are given by the manifest\n");
+        }
+        if ( !batchReadManifest(cliOptions.batchFileName, &batch) || !batchRun(&batch, &batchOptions) )
+        {
+            batchFree(&batch);
+            exit(EXIT_FAILURE);
+        }
+        uint32_t failed = batchSummary(stdout, &batch);
+        batchFree(&batch);
+        exit(failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    simOptions.verbosity = cliOptions.verbosity;
+    simOptions.stats     = cliOptions.stats;
+
+    if ( cliOptions.restoreFileName != NULL )
+    {
+        // Resume a snapshot, which brings its own guest memory and state
+        if ( !snapshotRestore(cliOptions.restoreFileName, &state, &mem) )
+        {
+            exit(EXIT_FAILURE);
+        }
+    }
+    else
+    {
+        // Reserve guest memory and load the program into it, starting at its entry point unless a start PC was given
+        if ( !guestMemCreate(&mem, cliOptions.memSize) )
+        {
+            exit(EXIT_FAILURE);
+        }
+        if ( !fileutilsLoadProgram(cliOptions.inFileName, format, mem.base, mem.size, cliOptions.loadAddress, &state.pc) )
+        {
+            guestMemDestroy(&mem);
+            exit(EXIT_FAILURE);
+        }
+        state.pc = cliOptions.hasEntry ? cliOptions.entry : state.pc;
+        if ( state.pc >= mem.size )
+        {
+            fprintf(stderr, "RiVIS error: Start PC 0x%08x outside guest memory\n", state.pc);
+            guestMemDestroy(&mem);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // The binary trace is opened once and statistics are summed, so both cover all phases of the run below
+    if ( cliOptions.traceFileName != NULL &&
+         (simOptions.trace = traceOpen(cliOptions.traceFileName, TRACE_DEFAULT_CAPACITY)) == NULL )
+    {
+        guestMemDestroy(&mem);
+        exit(EXIT_FAILURE);
+    }
+
+    // Run program, on the soft engine up to a requested snapshot and each checkpoint after it, and then on the
+    // selected engine. Checkpoints after the first only hold the pages written since the previous one.
+    int8_t res = SIM_RUN_LIMIT;
+    snapshotAt = (cliOptions.snapshotAt == 0 && cliOptions.snapshotEvery != 0) ? state.instructCount + cliOptions.snapshotEvery
+                                                                                : cliOptions.snapshotAt;
+    if ( snapshotAt != 0 && snapshotAt <= state.instructCount )
+    {
+        fprintf(stderr, "RiVIS warning: Instruction %" PRIu64 " already executed, no snapshot written\n", snapshotAt);
+    }
+    while ( res == SIM_RUN_LIMIT && snapshotAt > state.instructCount )
+    {
+        simOptions.instructLimit = snapshotAt;
+        res = simRun(SIM_ENGINE_SOFT, mem.base, mem.size, &state, &simOptions, &phase);
+        simStatsAdd(&stats, &phase);
+        simOptions.instructLimit = 0;
+        if ( res == SIM_RUN_LIMIT &&
+             !( checkpoints == 0 ? snapshotSave(cliOptions.snapshotFileName, &state, &mem) &&
+                                   (cliOptions.snapshotEvery == 0 || guestMemTrack(&mem))
+                                 : snapshotAppend(cliOptions.snapshotFileName, &state, &mem) ) )
+        {
+            traceClose(simOptions.trace);
+            guestMemDestroy(&mem);
+            exit(EXIT_FAILURE);
+        }
+        checkpoints += (res == SIM_RUN_LIMIT);
+        snapshotAt  += cliOptions.snapshotEvery;
+    }
+    if ( snapshotAt > state.instructCount && checkpoints == 0 )
+    {
+        fprintf(stderr, "RiVIS warning: Program ended before instruction %" PRIu64 ", no snapshot written\n", snapshotAt);
+    }
+    if ( res == SIM_RUN_LIMIT )
+    {
+        res = simRun(engine, mem.base, mem.size, &state, &simOptions, &phase);
+        simStatsAdd(&stats, &phase);
+    }
+    if ( traceClose(simOptions.trace) != true && res != SIM_RUN_FAULT )
+    {
+        res = -1;
+    }
+    guestMemDestroy(&mem);
+
+    if ( cliOptions.stats )
+    {
+        simStatsPrint(stderr, &stats);
+    }
 
-    // If output file was given save regfile as binary file
-    if( cliOptions.outFileName != NULL )
+    // If output file was given save regfile as binary file. A faulted run leaves a partial register file, which is
+    // not saved, while other errors such as an unsupported ECALL end the program with a register file to compare.
+    if( cliOptions.outFileName != NULL && res != SIM_RUN_FAULT )
     {
-        if ( fileutilsWriteBinary(cliOptions.outFileName, (uint8_t*) regFile, REGISTRY_FILE_SIZE_BYTES) != true )
+        if ( fileutilsWriteBinary(cliOptions.outFileName, (uint8_t*) state.regFile, REGISTRY_FILE_SIZE_BYTES) != true )
         {
             exit(EXIT_FAILURE);
         }
     }
 
-    exit(EXIT_SUCCESS);
+    exit( (res < 0) ? EXIT_FAILURE : EXIT_SUCCESS );
 }
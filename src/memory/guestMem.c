@@ -0,0 +1,335 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "guestMem.h"
+
+/*
+Mappings are made with MAP_NORESERVE, so the OS does not account the reserved size against its commit limit and
+only pages that are touched use host memory. Untouched pages read as zero.
+
+The fault handler is installed once and chains to the handlers installed before it for faults it does not claim,
+e.g. those outside guest memory or on threads not catching faults. Handlers installed later, such as the flight
+recorder's, chain to it in the same way.
+
+Tracked memories are registered in a table of slots, which the fault handler scans for the one holding the faulting
+address, as it has no other way to find the memory of a write by the host or by an engine that does not arm fault
+catching. Each write to a clean page makes it writable with mprotect, which splits the mapping, so tracking a
+large memory written at many scattered pages is bounded by the host limit on mappings per process.
+*/
+
+#define RESERVED_BYTES  ( GUEST_MEM_GUARD_BYTES + GUEST_MEM_SPACE_BYTES + GUEST_MEM_GUARD_BYTES )
+
+/* Tracked memory as seen by the fault handler */
+typedef struct track_slot_t
+{
+    _Atomic(uint8_t*) base;     // NULL for a free slot, stored after the other fields
+    uint64_t          size;
+    uint64_t*         dirty;
+    uint32_t          pageShift;
+} track_slot_t;
+
+static const int faultSignals[] = { SIGSEGV, SIGBUS };
+static struct sigaction previousActions[sizeof(faultSignals)/sizeof(faultSignals[0])];
+static _Thread_local guest_mem_fault_t* armedFault = NULL;
+static pthread_once_t handlerOnce = PTHREAD_ONCE_INIT;
+static track_slot_t trackSlots[GUEST_MEM_TRACK_MAX];
+static atomic_size_t trackSlotsUsed = 0;    // Slots ever claimed, bounds the handler's scan
+static pthread_mutex_t trackLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*** Static function prototypes ***/
+static void* mapZeroed(size_t size, int prot);
+static void  installHandler(void);
+static void  faultHandler(int sig, siginfo_t* info, void* context);
+static bool  markDirty(uint8_t* adr);
+static uint32_t pageShift(void);
+static bool  nextDirtyRun(const uint64_t* dirty, uint64_t pageCount, uint64_t* first, uint64_t* end);
+static void  cleanDirty(guest_mem_t* mem, const guest_mem_t* image);
+
+/* Reserves the guest address space and makes its first size bytes, rounded up to whole pages, accessible.
+   size must be between 1 and GUEST_MEM_SPACE_BYTES. */
+bool guestMemCreate(guest_mem_t* mem, uint64_t size)
+{
+    uint64_t pageSize = (uint64_t) sysconf(_SC_PAGESIZE);
+
+    if (size == 0 || size > GUEST_MEM_SPACE_BYTES)
+    {
+        fprintf(stderr, "GuestMem error: Memory size of %" PRIu64 " B not within 1 B - 4 GiB\n", size);
+        return false;
+    }
+    if ( (mem->base = mapZeroed(RESERVED_BYTES, PROT_NONE)) == NULL )
+    {
+        perror("GuestMem error: Failed to reserve guest address space");
+        return false;
+    }
+    mem->base += GUEST_MEM_GUARD_BYTES;
+    mem->size  = (size + pageSize - 1) & ~(pageSize - 1);
+    mem->dirty = NULL;
+    if (mprotect(mem->base, mem->size, PROT_READ | PROT_WRITE) != 0)
+    {
+        perror("GuestMem error: Failed to make guest memory accessible");
+        munmap(mem->base - GUEST_MEM_GUARD_BYTES, RESERVED_BYTES);
+        mem->base = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+void guestMemDestroy(guest_mem_t* mem)
+{
+    if (mem->base != NULL)
+    {
+        guestMemUntrack(mem);
+        munmap(mem->base - GUEST_MEM_GUARD_BYTES, RESERVED_BYTES);
+        mem->base = NULL;
+    }
+}
+
+/* Allocates a zeroed host table of size bytes that is committed page by page on first touch, like guest memory.
+   Used for tables with an entry per guest word, which stay mostly untouched for large memories.
+   Returns NULL on failure. */
+void* guestMemShadowCreate(size_t size)
+{
+    return mapZeroed(size, PROT_READ | PROT_WRITE);
+}
+
+void guestMemShadowDestroy(void* shadow, size_t size)
+{
+    if (shadow != NULL)
+    {
+        munmap(shadow, size);
+    }
+}
+
+/* Arms fault catching for the memory at base, to be followed by sigsetjmp on fault->env, see guest_mem_fault_t */
+void guestMemArm(guest_mem_fault_t* fault, uint8_t* base)
+{
+    pthread_once(&handlerOnce, installHandler);
+    fault->base = base;
+    armedFault  = fault;
+}
+
+void guestMemDisarm(void)
+{
+    armedFault = NULL;
+}
+
+/* Starts recording the pages written to mem, all pages being clean. Does nothing if mem is already tracked.
+   Returns false on failure. */
+bool guestMemTrack(guest_mem_t* mem)
+{
+    uint64_t pageCount = mem->size >> pageShift();
+    size_t slot;
+
+    if (mem->dirty != NULL)
+    {
+        return true;
+    }
+    pthread_once(&handlerOnce, installHandler);
+    if ( (mem->dirty = calloc((pageCount + 63) / 64, sizeof(uint64_t))) == NULL )
+    {
+        fprintf(stderr, "GuestMem error: Failed to allocate dirty page bitmap\n");
+        return false;
+    }
+
+    pthread_mutex_lock(&trackLock);
+    for (slot = 0; slot < GUEST_MEM_TRACK_MAX && atomic_load(&trackSlots[slot].base) != NULL; slot++);
+    if (slot < GUEST_MEM_TRACK_MAX)
+    {
+        trackSlots[slot].size      = mem->size;
+        trackSlots[slot].dirty     = mem->dirty;
+        trackSlots[slot].pageShift = pageShift();
+        atomic_store_explicit(&trackSlots[slot].base, mem->base, memory_order_release);
+        trackSlotsUsed = (slot + 1 > trackSlotsUsed) ? slot + 1 : trackSlotsUsed;
+    }
+    pthread_mutex_unlock(&trackLock);
+    if (slot == GUEST_MEM_TRACK_MAX)
+    {
+        fprintf(stderr, "GuestMem error: More than %d memories tracked\n", GUEST_MEM_TRACK_MAX);
+        free(mem->dirty);
+        mem->dirty = NULL;
+        return false;
+    }
+
+    // Registered first, so the handler knows every page it protects
+    if (mprotect(mem->base, mem->size, PROT_READ) != 0)
+    {
+        perror("GuestMem error: Failed to write protect guest memory");
+        guestMemUntrack(mem);
+        return false;
+    }
+    return true;
+}
+
+/* Stops recording writes and makes all of mem writable */
+void guestMemUntrack(guest_mem_t* mem)
+{
+    if (mem->dirty == NULL)
+    {
+        return;
+    }
+    mprotect(mem->base, mem->size, PROT_READ | PROT_WRITE);
+
+    pthread_mutex_lock(&trackLock);
+    for (size_t slot = 0; slot < trackSlotsUsed; slot++)
+    {
+        if (atomic_load(&trackSlots[slot].base) == mem->base)
+        {
+            atomic_store(&trackSlots[slot].base, NULL);
+        }
+    }
+    pthread_mutex_unlock(&trackLock);
+    free(mem->dirty);
+    mem->dirty = NULL;
+}
+
+/* Returns true if the page holding guest address adr was written since tracking started or mem was last cleaned */
+bool guestMemIsDirty(const guest_mem_t* mem, uint64_t adr)
+{
+    uint64_t page = adr >> pageShift();
+
+    return mem->dirty != NULL && adr < mem->size && ( (mem->dirty[page / 64] >> (page % 64)) & 1 );
+}
+
+/* Marks every page of mem clean, write protecting the dirty ones again */
+void guestMemClean(guest_mem_t* mem)
+{
+    cleanDirty(mem, NULL);
+}
+
+/* Copies the dirty pages of mem back from image, a memory of the same size holding what mem held when tracking
+   started or it was last cleaned, and marks them clean. Costs a copy per dirty page rather than reloading mem. */
+void guestMemReset(guest_mem_t* mem, const guest_mem_t* image)
+{
+    cleanDirty(mem, image);
+}
+
+void* mapZeroed(size_t size, int prot)
+{
+    void* adr = mmap(NULL, size, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    return (adr == MAP_FAILED) ? NULL : adr;
+}
+
+void installHandler(void)
+{
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = faultHandler;
+    action.sa_flags     = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < sizeof(faultSignals)/sizeof(faultSignals[0]); i++)
+    {
+        sigaction(faultSignals[i], &action, &previousActions[i]);
+    }
+}
+
+/* Resolves writes to clean pages of tracked memories, claims faults inside the reservation of the armed guest
+   memory, and otherwise passes the signal on to the
+   handler installed before, or to the default action */
+void faultHandler(int sig, siginfo_t* info, void* context)
+{
+    guest_mem_fault_t* fault = armedFault;
+    uint8_t* adr = info->si_addr;
+    const struct sigaction* previous = &previousActions[sig == SIGSEGV ? 0 : 1];
+
+    if (sig == SIGSEGV && markDirty(adr))
+    {
+        return; // The write is repeated on the now writable page
+    }
+    if (fault != NULL && adr >= fault->base - GUEST_MEM_GUARD_BYTES && adr < fault->base + GUEST_MEM_SPACE_BYTES + GUEST_MEM_GUARD_BYTES)
+    {
+        armedFault = NULL;
+        fault->adr = (uint32_t) (adr - fault->base);    // Wraps for the guard regions, as the access did
+        siglongjmp(fault->env, 1);
+    }
+
+    if ( (previous->sa_flags & SA_SIGINFO) && previous->sa_sigaction != NULL )
+    {
+        previous->sa_sigaction(sig, info, context);
+    }
+    else if (previous->sa_handler != SIG_DFL && previous->sa_handler != SIG_IGN)
+    {
+        previous->sa_handler(sig);
+    }
+    else
+    {
+        signal(sig, SIG_DFL);
+        raise(sig);
+    }
+}
+
+/* Marks the page holding adr dirty and makes it writable, if it is in a tracked memory. Every address below the size
+   of a tracked memory is readable, so a fault there is a write to a clean page. Returns false for other addresses. */
+bool markDirty(uint8_t* adr)
+{
+    size_t used = atomic_load(&trackSlotsUsed);
+    track_slot_t* slot;
+    uint8_t* base;
+    uint64_t page;
+
+    for (size_t i = 0; i < used; i++)
+    {
+        slot = &trackSlots[i];
+        base = atomic_load_explicit(&slot->base, memory_order_acquire);
+        if (base != NULL && adr >= base && adr < base + slot->size)
+        {
+            page = (uint64_t) (adr - base) >> slot->pageShift;
+            slot->dirty[page / 64] |= (uint64_t) 1 << (page % 64);
+            return mprotect(base + (page << slot->pageShift), (size_t) 1 << slot->pageShift, PROT_READ | PROT_WRITE) == 0;
+        }
+    }
+    return false;
+}
+
+uint32_t pageShift(void)
+{
+    return (uint32_t) __builtin_ctzll((uint64_t) sysconf(_SC_PAGESIZE));
+}
+
+/* Finds the first run of dirty pages at or after page *end and sets [*first, *end) to it. Returns false if there is none. */
+bool nextDirtyRun(const uint64_t* dirty, uint64_t pageCount, uint64_t* first, uint64_t* end)
+{
+    uint64_t page = *end;
+
+    while (page < pageCount && ( (dirty[page / 64] >> (page % 64)) & 1 ) == 0)
+    {
+        page = ( (dirty[page / 64] >> (page % 64)) == 0 ) ? (page | 63) + 1 : page + 1;   // Skips the rest of a clean word
+    }
+    *first = page;
+    while (page < pageCount && ( (dirty[page / 64] >> (page % 64)) & 1 ))
+    {
+        page++;
+    }
+    *end = page;
+    return *first < pageCount;
+}
+
+/* Copies each run of dirty pages from image unless it is NULL, and write protects the run again */
+void cleanDirty(guest_mem_t* mem, const guest_mem_t* image)
+{
+    uint32_t shift = pageShift();
+    uint64_t pageCount = mem->size >> shift;
+    uint64_t first, end = 0;
+
+    if (mem->dirty == NULL)
+    {
+        return;
+    }
+    while (nextDirtyRun(mem->dirty, pageCount, &first, &end))
+    {
+        if (image != NULL)
+        {
+            memcpy(mem->base + (first << shift), image->base + (first << shift), (end - first) << shift);
+        }
+        mprotect(mem->base + (first << shift), (end - first) << shift, PROT_READ);
+    }
+    memset(mem->dirty, 0, (pageCount + 63) / 64 * sizeof(uint64_t));
+}
@@ -0,0 +1,67 @@
+#ifndef GUEST_MEM_H
+#define GUEST_MEM_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h> // For size_t
+#include <setjmp.h>
+
+/*
+Guest memory. The full 32-bit guest address space is reserved as one host mapping, of which the first size bytes
+are accessible. Pages are only committed by the OS when first touched, so a large memory costs no more than the
+pages a program actually uses, and creating it costs the same for every size.
+
+Accesses are never bounds checked. Guest addresses wrap at 4 GiB, guard regions surround the address space to catch
+accesses straddling its ends, and the space beyond size is inaccessible. Any bad access thus faults in the host, and
+a fault armed by guestMemArm turns the SIGSEGV or SIGBUS into a return to the engine with the faulting guest address.
+
+guestMemTrack records which pages are written from then on, by any engine or the host, in a bitmap. Clean pages
+are write protected, and the first write to one faults, marks it dirty and makes it writable again, so tracking
+costs one fault per page written rather than anything per store. guestMemClean starts a new interval of tracking,
+e.g. for incremental snapshots, and guestMemReset returns only the dirty pages to the contents of a base image.
+A tracked memory must be written by one thread at a time, and system calls writing to its clean pages, e.g. read(),
+fail with EFAULT instead of faulting.
+*/
+
+#define GUEST_MEM_SPACE_BYTES       ( (uint64_t) 1 << 32 )  // 32-bit guest address space
+#define GUEST_MEM_DEFAULT_BYTES     ( 1048576 )             // 1 MiB
+#define GUEST_MEM_GUARD_BYTES       ( 65536 )               // Inaccessible region on each side, a multiple of any page size
+#define GUEST_MEM_TRACK_MAX         ( 1024 )                // Memories tracked at once in the process
+
+typedef struct guest_mem_t
+{
+    uint8_t* base;  // Host address of guest address 0
+    uint64_t size;  // Accessible bytes from base, a multiple of the host page size
+    uint64_t* dirty;    // Bit per host page written since guestMemTrack or guestMemClean, NULL when not tracked
+} guest_mem_t;
+
+/* Guest access fault. Faulting accesses of this thread to the guest memory at base are caught once armed with
+
+       guestMemArm(&fault, base);
+       if (sigsetjmp(fault.env, 1) != 0)
+       {
+           // Returned to after a fault with fault.adr set, which disarms
+       }
+
+   in a function that stays active until guestMemDisarm is called. sigsetjmp may only be called in such a condition.
+   Locals of that function changed after sigsetjmp are indeterminate after a fault unless volatile, so run state is
+   best kept behind a pointer to the caller's. adr is set by the fault handler and is volatile for this reason. */
+typedef struct guest_mem_fault_t
+{
+    sigjmp_buf        env;      // Returned to from the fault handler
+    uint8_t*          base;     // Host address of guest address 0 of the memory watched
+    volatile uint32_t adr;      // Guest address of the faulting access
+} guest_mem_fault_t;
+
+bool  guestMemCreate      (guest_mem_t* mem, uint64_t size);
+void  guestMemDestroy     (guest_mem_t* mem);
+void* guestMemShadowCreate(size_t size);
+void  guestMemShadowDestroy(void* shadow, size_t size);
+void  guestMemArm         (guest_mem_fault_t* fault, uint8_t* base);
+void  guestMemDisarm      (void);
+bool  guestMemTrack       (guest_mem_t* mem);
+void  guestMemUntrack     (guest_mem_t* mem);
+bool  guestMemIsDirty     (const guest_mem_t* mem, uint64_t adr);
+void  guestMemClean       (guest_mem_t* mem);
+void  guestMemReset       (guest_mem_t* mem, const guest_mem_t* image);
+
+#endif // GUEST_MEM_H
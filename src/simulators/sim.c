@@ -0,0 +1,228 @@
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <assert.h>
+#include "sim.h"
+#include "simSoft.h"
+#include "simThreaded.h"
+#include "simBlock.h"
+
+/* Engine names as accepted on the command line, indexed by sim_engine_t */
+static const char* engineNames[] = {
+    [SIM_ENGINE_SOFT]     = "soft",
+    [SIM_ENGINE_THREADED] = "threaded",
+    [SIM_ENGINE_BLOCK]    = "block",
+    [SIM_ENGINE_JIT]      = "jit",
+    [SIM_ENGINE_TIERED]   = "tiered",
+};
+
+/* Cache of the engine the context was created for, the others are NULL */
+struct sim_context_t
+{
+    sim_engine_t          engine;
+    sim_soft_cache_t*     soft;
+    sim_threaded_cache_t* threaded;
+    sim_block_cache_t*    blocks;
+};
+
+/* Fusion pattern names for the statistics, indexed by sim_fusion_t */
+static const char* fusionNames[] = {
+    [SIM_FUSION_LUI_ADDI]   = "lui+addi",
+    [SIM_FUSION_AUIPC_JALR] = "auipc+jalr",
+    [SIM_FUSION_SLLI_SRLI]  = "slli+srli",
+};
+
+sim_engine_t simEngineFromName(const char* name)
+{
+    if (name == NULL)
+    {
+        return SIM_ENGINE_SOFT; // Default engine
+    }
+    for (size_t i = 0; i < sizeof(engineNames)/sizeof(engineNames[0]); i++)
+    {
+        if (strcmp(name, engineNames[i]) == 0)
+        {
+            return (sim_engine_t) i;
+        }
+    }
+    return SIM_ENGINE_UNKNOWN;
+}
+
+const char* simEngineName(sim_engine_t engine)
+{
+    if (engine < 0 || (size_t) engine >= sizeof(engineNames)/sizeof(engineNames[0]))
+    {
+        return "unknown";
+    }
+    return engineNames[engine];
+}
+
+/* Creates the context of runs of engine on the program memory prog. Returns NULL on failure. */
+sim_context_t* simContextCreate(sim_engine_t engine, uint8_t* prog, uint64_t progSize)
+{
+    sim_context_t* context;
+
+    if ( (context = calloc(1, sizeof(sim_context_t))) == NULL )
+    {
+        fprintf(stderr, "Sim error: Failed to allocate memory for engine context\n");
+        return NULL;
+    }
+    context->engine = engine;
+    switch (engine)
+    {
+    case SIM_ENGINE_SOFT:
+        context->soft = simSoftCacheCreate(progSize);
+        break;
+    case SIM_ENGINE_THREADED:
+        context->threaded = simThreadedCacheCreate(progSize);
+        break;
+    case SIM_ENGINE_BLOCK:
+        context->blocks = simBlockCacheCreate(prog, progSize, SIM_BLOCK_TRANSLATE);
+        break;
+    case SIM_ENGINE_JIT:
+        context->blocks = simBlockCacheCreate(prog, progSize, SIM_BLOCK_JIT);
+        break;
+    case SIM_ENGINE_TIERED:
+        context->blocks = simBlockCacheCreate(prog, progSize, SIM_BLOCK_TIERED);
+        break;
+    case SIM_ENGINE_UNKNOWN: // Fallthrough
+    default:
+        break;
+    }
+    if (context->soft == NULL && context->threaded == NULL && context->blocks == NULL)
+    {
+        free(context);
+        return NULL;
+    }
+    return context;
+}
+
+void simContextDestroy(sim_context_t* context)
+{
+    if (context != NULL)
+    {
+        simSoftCacheDestroy(context->soft);
+        simThreadedCacheDestroy(context->threaded);
+        simBlockCacheDestroy(context->blocks);
+        free(context);
+    }
+}
+
+int8_t simRun(sim_engine_t engine, uint8_t* prog, uint64_t progSize, sim_state_t* state, const sim_options_t* options, sim_stats_t* stats)
+{
+    int8_t retVal;
+    struct timespec start, end;
+    uint64_t startCount;
+    sim_soft_probes_t probes = {0};
+    sim_block_stats_t blockStats = {0};
+    sim_threaded_cache_t* threadedCache = (options != NULL && options->context != NULL) ? options->context->threaded : NULL;
+    sim_block_cache_t* blockCache = (options != NULL && options->context != NULL) ? options->context->blocks : NULL;
+
+    assert(state != NULL && "state must not be NULL\n");
+    assert(options != NULL && "options must not be NULL\n");
+    assert(stats != NULL && "stats must not be NULL\n");
+    assert( (options->context == NULL || options->context->engine == engine) && "context must be created for engine\n");
+
+    stats->engine = engine;
+    stats->instructCount = 0;
+    stats->translated = 0;
+    stats->compiled = 0;
+    memset(stats->fused, 0, sizeof(stats->fused));
+    memset(stats->instructMix, 0, sizeof(stats->instructMix));
+
+    if (engine == SIM_ENGINE_SOFT)
+    {
+        probes.instrument |= (options->verbosity >= 1) ? SIM_SOFT_TRACE : 0;
+        probes.instrument |= (options->verbosity >= 2) ? SIM_SOFT_REGDUMP : 0;
+        probes.instrument |= options->stats ? SIM_SOFT_STATS : 0;
+        probes.instructMix = stats->instructMix;
+        probes.instructLimit = options->instructLimit;
+        probes.cache = (options->context != NULL) ? options->context->soft : NULL;
+        probes.trace = options->trace;
+        probes.instrument |= (options->trace != NULL) ? SIM_SOFT_BINTRACE : 0;
+    }
+
+    startCount = state->instructCount;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    switch (engine)
+    {
+    case SIM_ENGINE_SOFT:
+        retVal = simSoftRun(prog, progSize, state, &probes);
+        break;
+    case SIM_ENGINE_THREADED:
+        retVal = simThreadedRun(prog, progSize, state, options->instructLimit, threadedCache);
+        break;
+    case SIM_ENGINE_BLOCK:
+        retVal = simBlockRun(prog, progSize, state, SIM_BLOCK_TRANSLATE, options->instructLimit, blockCache, &blockStats);
+        break;
+    case SIM_ENGINE_JIT:
+        retVal = simBlockRun(prog, progSize, state, SIM_BLOCK_JIT, options->instructLimit, blockCache, &blockStats);
+        break;
+    case SIM_ENGINE_TIERED:
+        retVal = simBlockRun(prog, progSize, state, SIM_BLOCK_TIERED, options->instructLimit, blockCache, &blockStats);
+        break;
+    case SIM_ENGINE_UNKNOWN: // Fallthrough
+    default:
+        fprintf(stderr, "Sim error: Unknown engine %d\n", engine);
+        retVal = -1;
+        break;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (engine == SIM_ENGINE_BLOCK || engine == SIM_ENGINE_JIT || engine == SIM_ENGINE_TIERED)
+    {
+        stats->translated    = blockStats.translated;
+        stats->compiled      = blockStats.compiled;
+        memcpy(stats->fused, blockStats.fused, sizeof(stats->fused));
+    }
+    stats->instructCount = state->instructCount - startCount;
+    stats->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+
+    return retVal;
+}
+
+/* Adds the statistics of a run to total, e.g. to report a program run in several phases as one. The engine is the
+   one of the latest run. */
+void simStatsAdd(sim_stats_t* total, const sim_stats_t* stats)
+{
+    total->engine         = stats->engine;
+    total->instructCount += stats->instructCount;
+    total->translated    += stats->translated;
+    total->compiled      += stats->compiled;
+    for (size_t i = 0; i < SIM_FUSION_COUNT; i++)
+    {
+        total->fused[i] += stats->fused[i];
+    }
+    for (size_t i = 0; i < RV32I_INSTRUCT_COUNT; i++)
+    {
+        total->instructMix[i] += stats->instructMix[i];
+    }
+    total->seconds += stats->seconds;
+}
+
+void simStatsPrint(FILE* stream, const sim_stats_t* stats)
+{
+    double mips = (stats->seconds > 0.0) ? stats->instructCount / stats->seconds * 1e-6 : 0.0;
+
+    fprintf(stream, "Sim stats: engine = %s\n", simEngineName(stats->engine));
+    fprintf(stream, "Sim stats: instructions = %" PRIu64 "\n", stats->instructCount);
+    if (stats->engine == SIM_ENGINE_BLOCK || stats->engine == SIM_ENGINE_JIT || stats->engine == SIM_ENGINE_TIERED)
+    {
+        fprintf(stream, "Sim stats: blocks promoted to translated = %" PRIu64 "\n", stats->translated);
+        fprintf(stream, "Sim stats: blocks promoted to native = %" PRIu64 "\n", stats->compiled);
+        for (int i = 0; i < SIM_FUSION_COUNT; i++)
+        {
+            fprintf(stream, "Sim stats: fused %s = %" PRIu64 "\n", fusionNames[i], stats->fused[i]);
+        }
+    }
+    for (int i = 0; i < RV32I_INSTRUCT_COUNT; i++)
+    {
+        if (stats->instructMix[i] != 0)
+        {
+            fprintf(stream, "Sim stats: executed %s = %" PRIu64 "\n", rv32iInstructName(i), stats->instructMix[i]);
+        }
+    }
+    fprintf(stream, "Sim stats: time = %.6f s\n", stats->seconds);
+    fprintf(stream, "Sim stats: MIPS = %.2f\n", mips);
+}
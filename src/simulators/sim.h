@@ -0,0 +1,56 @@
+#ifndef SIM_H
+#define SIM_H
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include "simOp.h"
+#include "simState.h"
+#include "trace.h"
+
+/*
+Common entry point for the simulator engines. All engines run on the same sim_state_t and leave identical register
+files in it, and differ only in how instructions are dispatched.
+*/
+
+/* Available execution engines */
+typedef enum sim_engine_t
+{
+    SIM_ENGINE_UNKNOWN = -1, SIM_ENGINE_SOFT = 0, SIM_ENGINE_THREADED, SIM_ENGINE_BLOCK, SIM_ENGINE_JIT, SIM_ENGINE_TIERED,
+} sim_engine_t;
+
+/* Engine state of one program memory kept between runs, e.g. predecoded instructions, translated blocks and native
+   code, so a run resumed after an instruction limit continues warm rather than starting over */
+typedef struct sim_context_t sim_context_t;
+
+/* Options of a run */
+typedef struct sim_options_t
+{
+    int8_t      verbosity;      // Soft engine only. 1 traces every instruction, 2 also prints the register file after each.
+    bool        stats;          // Collect statistics that cost time during the run, e.g. the instruction mix of the soft engine
+    trace_t*    trace;          // Soft engine only. Binary trace opened by the caller, appended to by every run, NULL for none.
+    uint64_t    instructLimit;  // Stop with SIM_RUN_LIMIT once the state's instruction count reaches this, 0 for no limit. The soft engine stops
+                                // exactly at it, block based engines at the next block boundary, and the threaded engine at the next jump.
+    sim_context_t* context;     // Created by simContextCreate for the engine and memory of the run, NULL for a context of this run only
+} sim_options_t;
+
+/* Run statistics filled in by simRun */
+typedef struct sim_stats_t
+{
+    sim_engine_t engine;
+    uint64_t     instructCount;  // Number of instructions executed by this run
+    uint64_t     translated;     // Blocks promoted to translated micro-ops, block based engines only
+    uint64_t     compiled;       // Blocks promoted to native code, block based engines only
+    uint64_t     fused[SIM_FUSION_COUNT];    // Executed fused micro-ops per pattern, block based engines only
+    uint64_t     instructMix[RV32I_INSTRUCT_COUNT];  // Executed instructions per type, soft engine with stats option only
+    double       seconds;        // Wall-clock time spent in the engine
+} sim_stats_t;
+
+sim_engine_t   simEngineFromName(const char* name);
+const char*    simEngineName(sim_engine_t engine);
+sim_context_t* simContextCreate(sim_engine_t engine, uint8_t* prog, uint64_t progSize);
+void           simContextDestroy(sim_context_t* context);
+int8_t         simRun(sim_engine_t engine, uint8_t* prog, uint64_t progSize, sim_state_t* state, const sim_options_t* options, sim_stats_t* stats);
+void           simStatsAdd(sim_stats_t* total, const sim_stats_t* stats);
+void           simStatsPrint(FILE* stream, const sim_stats_t* stats);
+
+#endif // SIM_H
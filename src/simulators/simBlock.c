@@ -0,0 +1,690 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include "simBlock.h"
+#include "simOp.h"
+#include "simJit.h"
+#include "guestMem.h"
+#include "flight.h"
+
+/*
+Basic block translation engine. Straight-line code up to and including the next control transfer (branch, JAL,
+JALR or ECALL) is translated once into a compact micro-op sequence. A block exits either to the static target of
+its terminator or to the word after it, and each of these successors is linked into the block the first time it
+is used. Only JALR pays a lookup in the block map on every execution.
+
+Stores to a word holding translated code end the current block and flush all translations, so self-modifying
+code executes the new instructions. Stores are checked against a table of the 4 KiB pages holding translated code,
+small enough to stay cached, and only those to such a page look up the written words, so data sharing a page with
+code costs a second lookup and not a flush.
+
+When a JIT is available, blocks executed JIT_THRESHOLD times are compiled to native code by simJit.c. Native
+blocks return the next PC, which is matched against the static successors to keep using the block links.
+
+Pairs of instructions forming common idioms are fused into a single micro-op at translation, see simOp.h.
+
+In tiered mode a block is first interpreted straight from program memory, decoded into a scratch block on every
+entry, and only translated once it has been entered TIER_WARM_THRESHOLD times. Programs that run each block a few
+times never pay for translation, while hot blocks continue to native code as above.
+
+The flight recorder gets a record for every block entered, interpreted or native, and a failed run dumps it.
+
+An instruction limit is checked between blocks, so a run stops at the first block boundary at or beyond it, up to
+BLOCK_MAX_INSTRUCTS - 1 instructions late, and the blocks themselves pay nothing for it.
+
+Loads and stores are not bounds checked, a bad guest access faults and returns to simBlockRun. Instructions are
+counted at block exits, and loads and stores write their PC to the context first, both interpreted and native, so a
+faulted run is left at the faulting instruction with the instructions before it in its block counted too. The run loop is kept out of line, as the locals of the function calling sigsetjmp are kept in memory, and
+the run state is kept in simBlockRun, as locals of that function changed after sigsetjmp are lost on a fault.
+*/
+
+#define BLOCK_MAX_INSTRUCTS (256)
+#define CODE_PAGE_SHIFT     (12)    // 4 KiB pages for tracking which memory holds translated code
+#define CODE_PAGE_COUNT     (1 << (32 - CODE_PAGE_SHIFT))   // Covers the 32-bit address space, no bounds checks needed
+#define JIT_THRESHOLD       (16)    // Block executions before the block is compiled to native code
+#define TIER_WARM_THRESHOLD (16)    // Block entries before a block is translated in tiered mode
+
+#define BLOCK_OP_BIAS       (-SIM_OP_FIRST)         // Makes every micro-op type a non-negative index
+
+/* Micro-ops are dispatched with computed goto where available, as in simThreaded.c */
+#if defined(__GNUC__) && !defined(SIM_BLOCK_PORTABLE)
+#define SIM_BLOCK_COMPUTED_GOTO
+#endif
+#if defined(__GNUC__)
+#define BLOCK_NOINLINE      __attribute__((noinline))
+#else
+#define BLOCK_NOINLINE
+#endif
+
+#define BLOCK_INSTRUCTS(X) \
+    X(ADD)  X(ADDI) X(AND)  X(ANDI) X(AUIPC) X(BEQ)  X(BGE)  X(BGEU) X(BLT)  X(BLTU) X(BNE)  X(ECALL) X(JAL) \
+    X(JALR) X(LB)   X(LBU)  X(LH)   X(LHU)   X(LUI)  X(LW)   X(OR)   X(ORI)  X(SB)   X(SH)   X(SLL)   X(SLLI) \
+    X(SLT)  X(SLTI) X(SLTIU) X(SLTU) X(SRA)  X(SRAI) X(SRL)  X(SRLI) X(SUB)  X(SW)   X(XOR)  X(XORI)
+
+/* Case labels for the portable switch dispatch */
+enum block_case_t
+{
+    BLOCK_CASE_CONTINUE = SIM_OP_CONTINUE, BLOCK_CASE_NOT_SUPPORTED = RV32I_NOT_SUPPORTED,
+    BLOCK_CASE_LUI_ADDI = SIM_OP_LUI_ADDI, BLOCK_CASE_AUIPC_JALR = SIM_OP_AUIPC_JALR, BLOCK_CASE_SLLI_SRLI = SIM_OP_SLLI_SRLI,
+#define X(name) BLOCK_CASE_##name = RV32I_##name,
+    BLOCK_INSTRUCTS(X)
+#undef X
+};
+
+typedef struct block_t
+{
+    uint32_t        startPc;
+    uint32_t        endPc;          // PC of the word after the block
+    uint32_t        takenPc;        // Static target of the terminating branch, JAL or fused AUIPC + JALR
+    struct block_t* taken;          // Chained successor at takenPc, NULL until first used
+    struct block_t* fallthrough;    // Chained successor at endPc, NULL until first used
+    struct block_t* next;           // List of all translated blocks
+    uint32_t        execCount;      // Executions while interpreted, compiled at JIT_THRESHOLD
+    uint32_t        instruct;       // First instruction word, for the flight recorder
+    sim_jit_fn_t    native;         // Compiled block, NULL while interpreted
+    sim_op_t        ops[];
+} block_t;
+
+struct sim_block_cache_t
+{
+    uint8_t*  prog;
+    uint64_t  progSize;
+    sim_block_mode_t mode;
+    block_t** map;          // Block starting at each program word, indexed by pc >> 2
+    uint8_t*  codePages;    // Non-zero for pages holding translated instructions, CODE_PAGE_COUNT entries
+    uint8_t*  codeWords;    // Non-zero for words holding translated instructions, indexed by adr >> 2
+    uint32_t  codePageLo;   // Range of pages marked in codePages since the last flush
+    uint32_t  codePageHi;
+    block_t*  blocks;
+    block_t*  scratch;      // Cold block decoded on every entry, tiered mode only
+    uint8_t*  heat;         // Entries of each cold block, indexed by pc >> 2, tiered mode only
+    sim_jit_t* jit;         // NULL when blocks are only interpreted
+    uint64_t  nTranslated;
+    uint64_t  nCompiled;
+};
+
+typedef enum block_exit_t
+{
+    BLOCK_EXIT_TAKEN = 0, BLOCK_EXIT_FALLTHROUGH, BLOCK_EXIT_INDIRECT, BLOCK_EXIT_CODE_WRITTEN, BLOCK_EXIT_ECALL_EXIT, BLOCK_EXIT_ERROR,
+} block_exit_t;
+
+/*** Static function prototypes ***/
+static BLOCK_NOINLINE int8_t runCaught(sim_block_cache_t* cache, sim_jit_ctx_t* ctx, sim_state_t* state, flight_recorder_t* flight, uint64_t instructLimit);
+static BLOCK_NOINLINE int8_t runBlocks(sim_block_cache_t* cache, sim_jit_ctx_t* ctx, sim_state_t* state, flight_recorder_t* flight, uint64_t instructLimit);
+static block_t* getBlock(sim_block_cache_t* cache, uint32_t pc, int8_t* retVal);
+static block_t* nextBlock(sim_block_cache_t* cache, block_t** link, uint32_t pc, int8_t* retVal);
+static block_t* translateBlock(sim_block_cache_t* cache, uint32_t pc);
+static uint32_t decodeBlock(sim_block_cache_t* cache, uint32_t pc, block_t* block);
+static void fuseOps(sim_op_t* ops, uint32_t nOps, uint32_t* takenPc);
+static void flushBlocks(sim_block_cache_t* cache);
+static enum block_exit_t executeBlock(const block_t* block, int32_t regFile[SIM_REG_COUNT + 1], sim_block_cache_t* cache, sim_jit_ctx_t* ctx, uint32_t* nextPc);
+static inline int isCode(const sim_block_cache_t* cache, uint32_t adr, uint8_t nBytes);
+
+/* Allocates an empty block cache for prog. Returns NULL on failure. */
+sim_block_cache_t* simBlockCacheCreate(uint8_t* prog, uint64_t progSize, sim_block_mode_t mode)
+{
+    sim_block_cache_t* cache;
+
+    if ( (cache = calloc(1, sizeof(sim_block_cache_t))) == NULL )
+    {
+        fprintf(stderr, "BlockSim error: Failed to allocate memory for block cache\n");
+        return NULL;
+    }
+    cache->prog       = prog;
+    cache->progSize   = progSize;
+    cache->mode       = mode;
+    cache->codePageLo = UINT32_MAX;
+    cache->map        = guestMemShadowCreate( (progSize + 3) / 4 * sizeof(block_t*) );
+    cache->codePages  = calloc( CODE_PAGE_COUNT, sizeof(uint8_t) );
+    cache->codeWords  = guestMemShadowCreate( (progSize + 3) / 4 * sizeof(uint8_t) );
+    if (mode == SIM_BLOCK_TIERED)
+    {
+        cache->scratch = malloc( sizeof(block_t) + (BLOCK_MAX_INSTRUCTS + 1) * sizeof(sim_op_t) );
+        cache->heat    = guestMemShadowCreate( (progSize + 3) / 4 * sizeof(uint8_t) );
+    }
+    if (cache->map == NULL || cache->codePages == NULL || cache->codeWords == NULL || (mode == SIM_BLOCK_TIERED && (cache->scratch == NULL || cache->heat == NULL)))
+    {
+        fprintf(stderr, "BlockSim error: Failed to allocate memory for block cache\n");
+        simBlockCacheDestroy(cache);
+        return NULL;
+    }
+    if (mode != SIM_BLOCK_TRANSLATE && (cache->jit = simJitCreate()) == NULL)
+    {
+        fprintf(stderr, "BlockSim warning: JIT not available on this host, blocks are interpreted\n");
+    }
+    return cache;
+}
+
+void simBlockCacheDestroy(sim_block_cache_t* cache)
+{
+    if (cache == NULL)
+    {
+        return;
+    }
+    flushBlocks(cache);
+    simJitDestroy(cache->jit);
+    guestMemShadowDestroy(cache->map, (cache->progSize + 3) / 4 * sizeof(block_t*));
+    free(cache->codePages);
+    guestMemShadowDestroy(cache->codeWords, (cache->progSize + 3) / 4 * sizeof(uint8_t));
+    free(cache->scratch);
+    guestMemShadowDestroy(cache->heat, (cache->progSize + 3) / 4 * sizeof(uint8_t));
+    free(cache);
+}
+
+int8_t simBlockRun(uint8_t* prog, uint64_t progSize, sim_state_t* state, sim_block_mode_t mode, uint64_t instructLimit, sim_block_cache_t* kept, sim_block_stats_t* stats)
+{
+    int8_t retVal;
+    sim_block_cache_t* cache = (kept != NULL) ? kept : simBlockCacheCreate(prog, progSize, mode);
+    uint64_t translated;
+    uint64_t compiled;
+    flight_recorder_t flight = { .blocks = true };
+    sim_jit_ctx_t ctx = {
+        .regFile  = state->regFile,
+        .prog     = prog,
+    };
+
+    if (cache == NULL)
+    {
+        return -1;
+    }
+    assert(cache->prog == prog && cache->progSize == progSize && cache->mode == mode && "cache must be created for the same memory and mode\n");
+    ctx.codePages = cache->codePages;
+    ctx.codeWords = cache->codeWords;
+    translated    = cache->nTranslated;
+    compiled      = cache->nCompiled;
+
+    flightArm(&flight);
+    retVal = runCaught(cache, &ctx, state, &flight, instructLimit);
+    flightDisarm();
+    if (retVal < 0)
+    {
+        flightDump(&flight, STDERR_FILENO);
+    }
+
+    state->instructCount += ctx.instructCount;
+    stats->translated    = cache->nTranslated - translated;
+    stats->compiled      = cache->nCompiled - compiled;
+    for (int i = 0; i < SIM_FUSION_COUNT; i++)
+    {
+        stats->fused[i] = ctx.fusionHits[i];
+    }
+    if (kept == NULL)
+    {
+        simBlockCacheDestroy(cache);
+    }
+    return retVal;
+}
+
+/* Runs blocks, reporting a guest access fault as an error. Kept out of line, and the run state read after a fault is
+   the caller's, so no local changed after sigsetjmp is read after it. */
+int8_t runCaught(sim_block_cache_t* cache, sim_jit_ctx_t* ctx, sim_state_t* state, flight_recorder_t* flight, uint64_t instructLimit)
+{
+    int8_t retVal;
+    guest_mem_fault_t fault;
+
+    guestMemArm(&fault, cache->prog);
+    if (sigsetjmp(fault.env, 1) != 0)
+    {
+        // state->pc is the start of the faulting block, whose slots map one to one to its words
+        ctx->instructCount += (ctx->accessPc - state->pc) / 4;
+        state->pc = ctx->accessPc;
+        fprintf(stderr, "BlockSim error: Access fault at address 0x%08x by instruction at PC = %d\n", fault.adr, state->pc);
+        flight->interrupted = true;
+        retVal = SIM_RUN_FAULT;
+    }
+    else
+    {
+        retVal = runBlocks(cache, ctx, state, flight, instructLimit);
+    }
+    guestMemDisarm();
+    return retVal;
+}
+
+/* Runs blocks from state->pc until the program ends or the instruction limit is reached. state->pc is kept at the
+   start of the executing block. */
+int8_t runBlocks(sim_block_cache_t* cache, sim_jit_ctx_t* ctx, sim_state_t* state, flight_recorder_t* flight, uint64_t instructLimit)
+{
+    int8_t retVal = 0;
+    uint64_t entries = 0;   // Blocks entered, numbering the flight records
+    uint64_t budget = UINT64_MAX;
+    uint32_t pc = state->pc;
+    block_t* block = NULL;
+    enum block_exit_t blockExit;
+
+    if (instructLimit != 0)
+    {
+        budget = (instructLimit > state->instructCount) ? instructLimit - state->instructCount : 0;
+    }
+
+    block = getBlock(cache, pc, &retVal);
+    while (block != NULL)
+    {
+        state->pc = pc;
+        if (ctx->instructCount >= budget)
+        {
+            retVal = SIM_RUN_LIMIT;
+            break;
+        }
+        flightRecord(flight, ++entries, pc, block->instruct);
+        if (block->native == NULL && cache->jit != NULL && ++block->execCount == JIT_THRESHOLD)
+        {
+            block->native = simJitCompile(cache->jit, block->ops, block->startPc, block->endPc); // NULL keeps it interpreted
+            cache->nCompiled += (block->native != NULL);
+        }
+
+        if (block->native != NULL)
+        {
+            pc = block->native(ctx);
+            if (ctx->codeWritten)
+            {
+                ctx->codeWritten = 0;
+                blockExit = BLOCK_EXIT_CODE_WRITTEN;
+            }
+            else if (pc == block->takenPc)
+            {
+                blockExit = BLOCK_EXIT_TAKEN;
+            }
+            else if (pc == block->endPc)
+            {
+                blockExit = BLOCK_EXIT_FALLTHROUGH;
+            }
+            else
+            {
+                blockExit = BLOCK_EXIT_INDIRECT;
+            }
+        }
+        else
+        {
+            blockExit = executeBlock(block, state->regFile, cache, ctx, &pc);
+        }
+
+        switch (blockExit)
+        {
+        case BLOCK_EXIT_TAKEN:
+            pc = block->takenPc;
+            block = nextBlock(cache, &block->taken, pc, &retVal);
+            break;
+        case BLOCK_EXIT_FALLTHROUGH:
+            pc = block->endPc;
+            block = nextBlock(cache, &block->fallthrough, pc, &retVal);
+            break;
+        case BLOCK_EXIT_INDIRECT:
+            block = getBlock(cache, pc, &retVal);
+            break;
+        case BLOCK_EXIT_CODE_WRITTEN:
+            flushBlocks(cache);
+            block = getBlock(cache, pc, &retVal);
+            break;
+        case BLOCK_EXIT_ECALL_EXIT:
+            block = NULL;
+            break;
+        case BLOCK_EXIT_ERROR: // Fallthrough
+        default:
+            retVal = -1;
+            block = NULL;
+            break;
+        }
+    }
+
+    state->pc = pc;
+    return retVal;
+}
+
+/* Returns the block starting at pc, translating it if needed. NULL ends the run, with retVal set on error. */
+block_t* getBlock(sim_block_cache_t* cache, uint32_t pc, int8_t* retVal)
+{
+    block_t* block;
+
+    if (pc >= cache->progSize)
+    {
+        return NULL;    // Ran past end of program memory
+    }
+    if (pc & 0b11)
+    {
+        fprintf(stderr, "BlockSim error: Jump to misaligned PC = %d\n", pc);
+        *retVal = SIM_RUN_FAULT;
+        return NULL;
+    }
+    if ( (block = cache->map[pc >> 2]) == NULL )
+    {
+        if (cache->heat != NULL && cache->heat[pc >> 2] < TIER_WARM_THRESHOLD)
+        {
+            cache->heat[pc >> 2]++;
+            decodeBlock(cache, pc, cache->scratch);
+            return cache->scratch;
+        }
+        if ( (block = translateBlock(cache, pc)) == NULL )
+        {
+            *retVal = -1;
+        }
+    }
+    return block;
+}
+
+/* Follows the link to the successor at pc, filling it on first use. Cold scratch blocks are never linked. */
+block_t* nextBlock(sim_block_cache_t* cache, block_t** link, uint32_t pc, int8_t* retVal)
+{
+    block_t* block = *link;
+
+    if (block == NULL)
+    {
+        block = getBlock(cache, pc, retVal);
+        if (block != cache->scratch)
+        {
+            *link = block;
+        }
+    }
+    return block;
+}
+
+block_t* translateBlock(sim_block_cache_t* cache, uint32_t pc)
+{
+    uint32_t nOps;
+    block_t* block;
+    block_t* shrunk;
+
+    if ( (block = malloc(sizeof(block_t) + (BLOCK_MAX_INSTRUCTS + 1) * sizeof(sim_op_t))) == NULL )
+    {
+        fprintf(stderr, "BlockSim error: Failed to allocate memory for block at PC = %d\n", pc);
+        return NULL;
+    }
+    nOps = decodeBlock(cache, pc, block);
+    if ( (shrunk = realloc(block, sizeof(block_t) + nOps * sizeof(sim_op_t))) != NULL )
+    {
+        block = shrunk;
+    }
+
+    block->next   = cache->blocks;
+    cache->blocks = block;
+    cache->map[pc >> 2] = block;
+    cache->nTranslated++;
+
+    return block;
+}
+
+/* Decodes the block starting at pc and marks its pages as code. Returns the number of micro-ops. */
+uint32_t decodeBlock(sim_block_cache_t* cache, uint32_t pc, block_t* block)
+{
+    sim_op_t* ops = block->ops;
+    uint32_t nOps = 0;
+    uint32_t adr = pc;
+    uint32_t takenPc = 0;
+    rv32i_decoded_t decoded;
+    sim_op_t* op;
+    int terminated = 0;
+
+    block->instruct = rv32iLoadWord(cache->prog + pc);
+    while (!terminated && nOps < BLOCK_MAX_INSTRUCTS && adr < cache->progSize)
+    {
+        decoded = rv32iDecode(rv32iLoadWord(cache->prog + adr));
+        op = &ops[nOps++];
+        op->type = decoded.type;
+        op->rd   = (decoded.rd == 0) ? SIM_REG_DISCARD : decoded.rd; // x0 is hardwired to 0, writes to it are discarded
+        op->rs1  = decoded.rs1;
+        op->rs2  = decoded.rs2;
+        op->imm  = decoded.imm;
+
+        switch (op->type)
+        {
+        case RV32I_BEQ:  // Fallthrough
+        case RV32I_BNE:  // Fallthrough
+        case RV32I_BLT:  // Fallthrough
+        case RV32I_BGE:  // Fallthrough
+        case RV32I_BLTU: // Fallthrough
+        case RV32I_BGEU: // Fallthrough
+        case RV32I_JAL:
+            op->imm += adr;
+            takenPc = op->imm;
+            terminated = 1;
+            break;
+        case RV32I_JALR:            // Fallthrough
+        case RV32I_ECALL:           // Fallthrough
+        case RV32I_NOT_SUPPORTED:   // Reported if execution reaches it
+            terminated = 1;
+            break;
+        case RV32I_AUIPC:
+            op->imm += adr;
+            break;
+        default:
+            break;
+        }
+        adr += 4;
+    }
+    fuseOps(ops, nOps, &takenPc);
+    if (!terminated)
+    {
+        ops[nOps++] = (sim_op_t) { .type = SIM_OP_CONTINUE };
+    }
+
+    block->startPc     = pc;
+    block->endPc       = adr;
+    block->takenPc     = takenPc;
+    block->taken       = NULL;
+    block->fallthrough = NULL;
+    block->next        = NULL;
+    block->execCount   = 0;
+    block->native      = NULL;
+
+    for (uint32_t page = pc >> CODE_PAGE_SHIFT; page <= (adr - 1) >> CODE_PAGE_SHIFT; page++)
+    {
+        cache->codePages[page] = 1;
+    }
+    memset(cache->codeWords + (pc >> 2), 1, (adr - pc) >> 2);
+    cache->codePageLo = (pc >> CODE_PAGE_SHIFT) < cache->codePageLo ? (pc >> CODE_PAGE_SHIFT) : cache->codePageLo;
+    cache->codePageHi = ((adr - 1) >> CODE_PAGE_SHIFT) > cache->codePageHi ? ((adr - 1) >> CODE_PAGE_SHIFT) : cache->codePageHi;
+
+    return nOps;
+}
+
+/* Replaces the first instruction of each fusable pair by its fused micro-op. A fused AUIPC + JALR has a static target. */
+void fuseOps(sim_op_t* ops, uint32_t nOps, uint32_t* takenPc)
+{
+    sim_op_t* first;
+    sim_op_t* second;
+
+    for (uint32_t i = 0; i + 1 < nOps; i++)
+    {
+        first  = &ops[i];
+        second = &ops[i + 1];
+        if (first->type == RV32I_LUI && second->type == RV32I_ADDI && second->rd == first->rd && second->rs1 == first->rd)
+        {
+            first->type = SIM_OP_LUI_ADDI;
+            first->imm += second->imm;
+            i++;
+        }
+        else if (first->type == RV32I_AUIPC && second->type == RV32I_JALR && first->rd != SIM_REG_DISCARD && second->rs1 == first->rd)
+        {
+            first->type = SIM_OP_AUIPC_JALR;
+            *takenPc = (first->imm + second->imm) & 0b11111111111111111111111111111110;
+            i++;
+        }
+        else if (first->type == RV32I_SLLI && second->type == RV32I_SRLI && second->rd == first->rd && second->rs1 == first->rd &&
+                 (first->imm & 0b11111) == (second->imm & 0b11111))
+        {
+            first->type = SIM_OP_SLLI_SRLI;
+            first->imm  = (int32_t) (0b11111111111111111111111111111111u >> (first->imm & 0b11111));
+            i++;
+        }
+    }
+}
+
+void flushBlocks(sim_block_cache_t* cache)
+{
+    block_t* next;
+    uint64_t wordLo = (uint64_t) cache->codePageLo << (CODE_PAGE_SHIFT - 2);
+    uint64_t wordHi = (uint64_t) (cache->codePageHi + 1) << (CODE_PAGE_SHIFT - 2);
+
+    for (block_t* block = cache->blocks; block != NULL; block = next)
+    {
+        next = block->next;
+        cache->map[block->startPc >> 2] = NULL;
+        free(block);
+    }
+    cache->blocks = NULL;
+    if (cache->codePageLo <= cache->codePageHi)
+    {
+        memset(cache->codePages + cache->codePageLo, 0, cache->codePageHi - cache->codePageLo + 1);
+        wordHi = (wordHi < (cache->progSize + 3) / 4) ? wordHi : (cache->progSize + 3) / 4;
+        memset(cache->codeWords + wordLo, 0, wordHi - wordLo);
+    }
+    cache->codePageLo = UINT32_MAX;
+    cache->codePageHi = 0;
+    if (cache->jit != NULL)
+    {
+        simJitReset(cache->jit);
+    }
+}
+
+int isCode(const sim_block_cache_t* cache, uint32_t adr, uint8_t nBytes)
+{
+    return (cache->codePages[adr >> CODE_PAGE_SHIFT] || cache->codePages[(adr + nBytes - 1) >> CODE_PAGE_SHIFT]) &&
+           (cache->codeWords[adr >> 2] || cache->codeWords[(adr + nBytes - 1) >> 2]);
+}
+
+enum block_exit_t executeBlock(const block_t* block, int32_t regFile[SIM_REG_COUNT + 1], sim_block_cache_t* cache, sim_jit_ctx_t* ctx, uint32_t* nextPc)
+{
+    uint8_t* prog = cache->prog;
+    const sim_op_t* op = block->ops;
+    uint32_t adr;
+
+#ifdef SIM_BLOCK_COMPUTED_GOTO
+    // Indexed by micro-op type + BLOCK_OP_BIAS
+    static const void* const handlers[] = {
+        [SIM_OP_CONTINUE    + BLOCK_OP_BIAS] = &&op_CONTINUE,
+        [RV32I_NOT_SUPPORTED  + BLOCK_OP_BIAS] = &&op_NOT_SUPPORTED,
+        [SIM_OP_LUI_ADDI    + BLOCK_OP_BIAS] = &&op_LUI_ADDI,
+        [SIM_OP_AUIPC_JALR  + BLOCK_OP_BIAS] = &&op_AUIPC_JALR,
+        [SIM_OP_SLLI_SRLI   + BLOCK_OP_BIAS] = &&op_SLLI_SRLI,
+#define X(name) [RV32I_##name + BLOCK_OP_BIAS] = &&op_##name,
+        BLOCK_INSTRUCTS(X)
+#undef X
+    };
+#define HANDLER(name)   op_##name
+#define DISPATCH()      goto *handlers[op->type + BLOCK_OP_BIAS]
+#else
+#define HANDLER(name)   case BLOCK_CASE_##name
+#define DISPATCH()      goto dispatch
+#endif
+
+#define RD          regFile[op->rd]
+#define RS1         regFile[op->rs1]
+#define RS2         regFile[op->rs2]
+#define PC_OF(op)   ( block->startPc + (uint32_t) ((op) - block->ops) * 4 )
+#define NEXT()      do { op++; DISPATCH(); } while (0)
+#define NEXT_FUSED(fusion) do { ctx->fusionHits[fusion]++; op += 2; DISPATCH(); } while (0)    // Skips the second slot
+#define RETIRE()    ( ctx->instructCount += (op - block->ops) + 1 )     // Account for all instructions up to and including op
+#define BRANCH(cond) do { RETIRE(); return (cond) ? BLOCK_EXIT_TAKEN : BLOCK_EXIT_FALLTHROUGH; } while (0)
+#define ACCESS()    ( ctx->accessPc = PC_OF(op) )   // Where a fault is reported
+#define STORE(store, nBytes) do { ACCESS(); adr = simAddress(RS1, op->imm); store(prog + adr, RS2); if (isCode(cache, adr, nBytes)) goto codeWritten; NEXT(); } while (0)
+
+#ifdef SIM_BLOCK_COMPUTED_GOTO
+    DISPATCH();
+#else
+dispatch:
+    switch (op->type)
+    {
+#endif
+
+    // ALU operations
+    HANDLER(ADD):   RD = RS1 + RS2; NEXT();
+    HANDLER(SUB):   RD = RS1 - RS2; NEXT();
+    HANDLER(SLL):   RD = RS1 << (RS2 & 0b11111); NEXT();
+    HANDLER(SLT):   RD = (RS1 < RS2) ? 1 : 0; NEXT();
+    HANDLER(SLTU):  RD = ( (uint32_t) RS1 < (uint32_t) RS2) ? 1 : 0; NEXT();
+    HANDLER(XOR):   RD = RS1 ^ RS2; NEXT();
+    HANDLER(SRL):   RD = (uint32_t) RS1 >> (RS2 & 0b11111); NEXT();
+    HANDLER(SRA):   RD = RS1 >> (RS2 & 0b11111); NEXT();
+    HANDLER(OR):    RD = RS1 | RS2; NEXT();
+    HANDLER(AND):   RD = RS1 & RS2; NEXT();
+    // ALU immediate operations
+    HANDLER(ADDI):  RD = RS1 + op->imm; NEXT();
+    HANDLER(SLTI):  RD = (RS1 < op->imm) ? 1 : 0; NEXT();
+    HANDLER(SLTIU): RD = ( (uint32_t) RS1 < (uint32_t) op->imm) ? 1 : 0; NEXT();
+    HANDLER(XORI):  RD = RS1 ^ op->imm; NEXT();
+    HANDLER(ORI):   RD = RS1 | op->imm; NEXT();
+    HANDLER(ANDI):  RD = RS1 & op->imm; NEXT();
+    HANDLER(SLLI):  RD = RS1 << (op->imm & 0b11111); NEXT();
+    HANDLER(SRLI):  RD = (uint32_t) RS1 >> (op->imm & 0b11111); NEXT();
+    HANDLER(SRAI):  RD = RS1 >> (op->imm & 0b11111); NEXT();
+    // Load operations
+    HANDLER(LB):    ACCESS(); RD = rv32iSignExtentByte(rv32iLoadByte(prog + simAddress(RS1, op->imm))); NEXT();
+    HANDLER(LH):    ACCESS(); RD = rv32iSignExtentHalfWord(rv32iLoadHalfWord(prog + simAddress(RS1, op->imm))); NEXT();
+    HANDLER(LW):    ACCESS(); RD = rv32iLoadWord(prog + simAddress(RS1, op->imm)); NEXT();
+    HANDLER(LBU):   ACCESS(); RD = rv32iLoadByte(prog + simAddress(RS1, op->imm)); NEXT();
+    HANDLER(LHU):   ACCESS(); RD = rv32iLoadHalfWord(prog + simAddress(RS1, op->imm)); NEXT();
+    // Upper immediates operations
+    HANDLER(LUI):   // Fallthrough, AUIPC immediate is absolute
+    HANDLER(AUIPC): RD = op->imm; NEXT();
+    // Store operations
+    HANDLER(SB):    STORE(rv32iStoreByte, 1);
+    HANDLER(SH):    STORE(rv32iStoreHalfWord, 2);
+    HANDLER(SW):    STORE(rv32iStoreWord, 4);
+    // Block terminators
+    HANDLER(BEQ):   BRANCH(RS1 == RS2);
+    HANDLER(BNE):   BRANCH(RS1 != RS2);
+    HANDLER(BLT):   BRANCH(RS1 <  RS2);
+    HANDLER(BGE):   BRANCH(RS1 >= RS2);
+    HANDLER(BLTU):  BRANCH( (uint32_t) RS1 <  (uint32_t) RS2);
+    HANDLER(BGEU):  BRANCH( (uint32_t) RS1 >= (uint32_t) RS2);
+    HANDLER(JAL):
+        RD = PC_OF(op) + 4;
+        RETIRE();
+        return BLOCK_EXIT_TAKEN;
+    HANDLER(JALR):
+        *nextPc = (RS1 + op->imm) & 0b11111111111111111111111111111110; // Read rs1 before rd is written, they may be equal
+        RD = PC_OF(op) + 4;
+        RETIRE();
+        return BLOCK_EXIT_INDIRECT;
+    HANDLER(ECALL):
+        RETIRE();
+        *nextPc = PC_OF(op) + 4;
+        if (regFile[17] != 10) // ECALL exit at a7 = 10 defined in assignment specification
+        {
+            fprintf(stderr, "BlockSim error: Unsuported ECALL with argument a7 = %d at PC = %d\n", regFile[17], PC_OF(op));
+            return BLOCK_EXIT_ERROR;
+        }
+        return BLOCK_EXIT_ECALL_EXIT;
+    // Fused operations
+    HANDLER(LUI_ADDI):  RD = op->imm; NEXT_FUSED(SIM_FUSION_LUI_ADDI);
+    HANDLER(SLLI_SRLI): RD = RS1 & op->imm; NEXT_FUSED(SIM_FUSION_SLLI_SRLI);
+    HANDLER(AUIPC_JALR):
+        RD = op->imm;
+        regFile[(op + 1)->rd] = PC_OF(op + 1) + 4;
+        ctx->fusionHits[SIM_FUSION_AUIPC_JALR]++;
+        ctx->instructCount += (op - block->ops) + 2;
+        return BLOCK_EXIT_TAKEN;
+    HANDLER(CONTINUE):
+        ctx->instructCount += op - block->ops;
+        return BLOCK_EXIT_FALLTHROUGH;
+    HANDLER(NOT_SUPPORTED):
+        ctx->instructCount += op - block->ops;
+        *nextPc = PC_OF(op);
+        fprintf(stderr, "BlockSim error: Decoder encountered unsuported instruction 0x%08x at PC = %d\n", rv32iLoadWord(prog + PC_OF(op)), PC_OF(op));
+        return BLOCK_EXIT_ERROR;
+
+#ifndef SIM_BLOCK_COMPUTED_GOTO
+    default:
+        return BLOCK_EXIT_ERROR;
+    }
+#endif
+
+codeWritten:
+    RETIRE();
+    *nextPc = PC_OF(op) + 4;
+    return BLOCK_EXIT_CODE_WRITTEN;
+
+#undef HANDLER
+#undef DISPATCH
+#undef RD
+#undef RS1
+#undef RS2
+#undef PC_OF
+#undef NEXT
+#undef NEXT_FUSED
+#undef RETIRE
+#undef BRANCH
+#undef STORE
+#undef ACCESS
+}
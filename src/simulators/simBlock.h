@@ -0,0 +1,32 @@
+#ifndef SIM_BLOCK_H
+#define SIM_BLOCK_H
+#include <stdint.h>
+#include "simOp.h"
+#include "simState.h"
+
+/* How far blocks are promoted. Translated blocks are interpreted as micro-ops, and JIT modes compile hot blocks
+   to native code where available. Tiered mode interprets cold blocks without translating them. */
+typedef enum sim_block_mode_t
+{
+    SIM_BLOCK_TRANSLATE = 0, SIM_BLOCK_JIT, SIM_BLOCK_TIERED,
+} sim_block_mode_t;
+
+typedef struct sim_block_stats_t
+{
+    uint64_t translated;     // Blocks promoted to translated micro-ops
+    uint64_t compiled;       // Blocks promoted to native code
+    uint64_t fused[SIM_FUSION_COUNT];   // Executed fused micro-ops per pattern
+} sim_block_stats_t;
+
+/* Translated blocks and native code of one program memory, kept between runs so a run resumed after an instruction
+   limit does not translate and compile its blocks again */
+typedef struct sim_block_cache_t sim_block_cache_t;
+
+sim_block_cache_t* simBlockCacheCreate (uint8_t* prog, uint64_t progSize, sim_block_mode_t mode);
+void               simBlockCacheDestroy(sim_block_cache_t* cache);
+
+/* instructLimit stops the run with SIM_RUN_LIMIT at the first block boundary where state->instructCount has reached
+   it, 0 for no limit. cache is a cache created for prog and mode, or NULL for one that only lives for this run. */
+int8_t simBlockRun(uint8_t* prog, uint64_t progSize, sim_state_t* state, sim_block_mode_t mode, uint64_t instructLimit, sim_block_cache_t* cache, sim_block_stats_t* stats);
+
+#endif // SIM_BLOCK_H
@@ -0,0 +1,487 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "simJit.h"
+
+/*
+Every guest register lives in the register file in memory and is loaded and stored around each operation, so
+the generated code keeps the exact register file contents of the interpreters. Writes to the x0 discard slot
+are not emitted. Loads and stores first write their PC to the context, where a fault is reported.
+
+Register use in generated code:
+    rbx = regFile, r12 = prog, r13 = codePages, r14 = ctx
+    eax, ecx, edx = scratch
+Only callee saved registers are used for state, so no host ABI state needs saving beyond the prologue.
+
+Code is never writable and executable at once. It is emitted to chunks mapped read and write as they are needed,
+so a JIT that compiles little costs little, and a chunk is made read and execute before a block in it is returned.
+A chunk is only made writable again while the next block is emitted to it, when none of its code is running.
+*/
+
+#define JIT_CODE_SIZE       (16 * 1024 * 1024)  // Native code of one JIT at most. When used up, further blocks stay interpreted.
+#define JIT_CHUNK_SIZE      (256 * 1024)        // Code is mapped in chunks of this size as needed
+#define JIT_MAX_CHUNKS      (JIT_CODE_SIZE / JIT_CHUNK_SIZE)
+#define JIT_MAX_BLOCK_CODE  (64 * 1024)         // Upper bound of generated code for one block
+#define CODE_PAGE_SHIFT     (12)
+
+#define CTX_INSTRUCT_COUNT  (24)
+#define CTX_CODE_WRITTEN    (32)
+#define CTX_ACCESS_PC       (36)
+#define CTX_CODE_WORDS      (40)
+#define CTX_FUSION_HITS     (48)
+
+#if defined(__x86_64__)
+
+struct sim_jit_t
+{
+    uint8_t* chunks[JIT_MAX_CHUNKS];    // Read and execute, but for the one a block is being emitted to
+    uint32_t nChunks;
+    uint32_t current;                   // Chunk blocks are emitted to
+    size_t   used;                      // Bytes of the current chunk holding code
+    bool     mapFailed;                 // Mapping a chunk failed, and the warning was printed
+};
+
+typedef struct emitter_t
+{
+    uint8_t* start;
+    uint8_t* pos;
+} emitter_t;
+
+/*** Static function prototypes ***/
+static uint8_t* writableChunk(sim_jit_t* jit);
+static inline void emit8 (emitter_t* e, uint8_t  byte);
+static inline void emit32(emitter_t* e, uint32_t word);
+static void emitBytes(emitter_t* e, const uint8_t* bytes, size_t n);
+static void emitLoadReg(emitter_t* e, uint8_t hostReg, uint8_t guestReg);
+static void emitStoreEax(emitter_t* e, uint8_t guestReg);
+static void emitStoreImm(emitter_t* e, uint8_t guestReg, int32_t imm);
+static void emitAluReg(emitter_t* e, uint8_t opcode, const sim_op_t* op);
+static void emitAluImm(emitter_t* e, uint8_t opcode, const sim_op_t* op);
+static void emitShiftReg(emitter_t* e, uint8_t modrm, const sim_op_t* op);
+static void emitShiftImm(emitter_t* e, uint8_t modrm, const sim_op_t* op);
+static void emitSetCond(emitter_t* e, uint8_t setcc, const sim_op_t* op, bool immediate);
+static void emitEffectiveAddress(emitter_t* e, const sim_op_t* op);
+static void emitAccessPc(emitter_t* e, uint32_t pc);
+static void emitLoad(emitter_t* e, const uint8_t* load, size_t n, const sim_op_t* op, uint32_t pc);
+static void emitStore(emitter_t* e, const uint8_t* store, size_t n, uint8_t nBytes, const sim_op_t* op, uint32_t pc, uint32_t retired);
+static void emitExit(emitter_t* e, uint32_t retired);
+static void emitFusionHit(emitter_t* e, sim_fusion_t fusion);
+static void emitBranch(emitter_t* e, uint8_t cmovcc, const sim_op_t* op, uint32_t fallthroughPc, uint32_t retired);
+
+/* Creates a JIT without any code memory, which is mapped by the first block compiled */
+sim_jit_t* simJitCreate(void)
+{
+    return calloc(1, sizeof(sim_jit_t));
+}
+
+void simJitDestroy(sim_jit_t* jit)
+{
+    if (jit != NULL)
+    {
+        for (uint32_t i = 0; i < jit->nChunks; i++)
+        {
+            munmap(jit->chunks[i], JIT_CHUNK_SIZE);
+        }
+        free(jit);
+    }
+}
+
+/* Drops all compiled blocks. The chunks stay mapped and are reused from the first. */
+void simJitReset(sim_jit_t* jit)
+{
+    jit->current = 0;
+    jit->used    = 0;
+}
+
+sim_jit_fn_t simJitCompile(sim_jit_t* jit, const sim_op_t* ops, uint32_t startPc, uint32_t endPc)
+{
+    static const uint8_t prologue[] = {
+        0x53,                       // push rbx
+        0x41, 0x54,                 // push r12
+        0x41, 0x55,                 // push r13
+        0x41, 0x56,                 // push r14
+        0x49, 0x89, 0xFE,           // mov  r14, rdi
+        0x48, 0x8B, 0x1F,           // mov  rbx, [rdi]          regFile
+        0x4C, 0x8B, 0x67, 0x08,     // mov  r12, [rdi+8]        prog
+        0x4C, 0x8B, 0x6F, 0x10,     // mov  r13, [rdi+16]       codePages
+    };
+    static const uint8_t ldB [] = {0x41, 0x0F, 0xBE, 0x04, 0x04};   // movsx eax, byte  [r12+rax]
+    static const uint8_t ldBU[] = {0x41, 0x0F, 0xB6, 0x04, 0x04};   // movzx eax, byte  [r12+rax]
+    static const uint8_t ldH [] = {0x41, 0x0F, 0xBF, 0x04, 0x04};   // movsx eax, word  [r12+rax]
+    static const uint8_t ldHU[] = {0x41, 0x0F, 0xB7, 0x04, 0x04};   // movzx eax, word  [r12+rax]
+    static const uint8_t ldW [] = {0x41, 0x8B, 0x04, 0x04};         // mov   eax, dword [r12+rax]
+    static const uint8_t stB [] = {0x41, 0x88, 0x0C, 0x04};         // mov   byte  [r12+rax], cl
+    static const uint8_t stH [] = {0x66, 0x41, 0x89, 0x0C, 0x04};   // mov   word  [r12+rax], cx
+    static const uint8_t stW [] = {0x41, 0x89, 0x0C, 0x04};         // mov   dword [r12+rax], ecx
+
+    emitter_t e;
+    const sim_op_t* op;
+    uint8_t* chunk;
+    uint32_t pc = startPc;
+    uint32_t nOps = 0;
+
+    // Blocks ending in ECALL or an unsupported instruction are left to the interpreter
+    for (op = ops; op->type != SIM_OP_CONTINUE; op++)
+    {
+        if (op->type == RV32I_ECALL || op->type == RV32I_NOT_SUPPORTED)
+        {
+            return NULL;
+        }
+        nOps++;
+        if (op->type == RV32I_BEQ  || op->type == RV32I_BNE  || op->type == RV32I_BLT  || op->type == RV32I_BGE ||
+            op->type == RV32I_BLTU || op->type == RV32I_BGEU || op->type == RV32I_JAL  || op->type == RV32I_JALR)
+        {
+            break;
+        }
+    }
+    if (nOps * 128 + 64 > JIT_MAX_BLOCK_CODE || (chunk = writableChunk(jit)) == NULL)
+    {
+        return NULL;
+    }
+
+    e.start = e.pos = chunk + jit->used;
+    emitBytes(&e, prologue, sizeof(prologue));
+
+    for (op = ops; ; op++, pc += 4)
+    {
+        uint32_t retired = (uint32_t) (op - ops) + 1;
+        switch (op->type)
+        {
+        // ALU operations
+        case RV32I_ADD:   emitAluReg(&e, 0x03, op); break;
+        case RV32I_SUB:   emitAluReg(&e, 0x2B, op); break;
+        case RV32I_AND:   emitAluReg(&e, 0x23, op); break;
+        case RV32I_OR:    emitAluReg(&e, 0x0B, op); break;
+        case RV32I_XOR:   emitAluReg(&e, 0x33, op); break;
+        case RV32I_SLL:   emitShiftReg(&e, 0xE0, op); break;
+        case RV32I_SRL:   emitShiftReg(&e, 0xE8, op); break;
+        case RV32I_SRA:   emitShiftReg(&e, 0xF8, op); break;
+        case RV32I_SLT:   emitSetCond(&e, 0x9C, op, false); break;
+        case RV32I_SLTU:  emitSetCond(&e, 0x92, op, false); break;
+        // ALU immediate operations
+        case RV32I_ADDI:  emitAluImm(&e, 0x05, op); break;
+        case RV32I_ANDI:  emitAluImm(&e, 0x25, op); break;
+        case RV32I_ORI:   emitAluImm(&e, 0x0D, op); break;
+        case RV32I_XORI:  emitAluImm(&e, 0x35, op); break;
+        case RV32I_SLLI:  emitShiftImm(&e, 0xE0, op); break;
+        case RV32I_SRLI:  emitShiftImm(&e, 0xE8, op); break;
+        case RV32I_SRAI:  emitShiftImm(&e, 0xF8, op); break;
+        case RV32I_SLTI:  emitSetCond(&e, 0x9C, op, true); break;
+        case RV32I_SLTIU: emitSetCond(&e, 0x92, op, true); break;
+        // Upper immediates operations, AUIPC immediate is absolute
+        case RV32I_LUI:   // Fallthrough
+        case RV32I_AUIPC: emitStoreImm(&e, op->rd, op->imm); break;
+        // Load operations
+        case RV32I_LB:    emitLoad(&e, ldB,  sizeof(ldB),  op, pc); break;
+        case RV32I_LBU:   emitLoad(&e, ldBU, sizeof(ldBU), op, pc); break;
+        case RV32I_LH:    emitLoad(&e, ldH,  sizeof(ldH),  op, pc); break;
+        case RV32I_LHU:   emitLoad(&e, ldHU, sizeof(ldHU), op, pc); break;
+        case RV32I_LW:    emitLoad(&e, ldW,  sizeof(ldW),  op, pc); break;
+        // Store operations
+        case RV32I_SB:    emitStore(&e, stB, sizeof(stB), 1, op, pc, retired); break;
+        case RV32I_SH:    emitStore(&e, stH, sizeof(stH), 2, op, pc, retired); break;
+        case RV32I_SW:    emitStore(&e, stW, sizeof(stW), 4, op, pc, retired); break;
+        // Block terminators, cmovcc taken target over fall through PC
+        case RV32I_BEQ:   emitBranch(&e, 0x44, op, pc + 4, retired); goto done;
+        case RV32I_BNE:   emitBranch(&e, 0x45, op, pc + 4, retired); goto done;
+        case RV32I_BLT:   emitBranch(&e, 0x4C, op, pc + 4, retired); goto done;
+        case RV32I_BGE:   emitBranch(&e, 0x4D, op, pc + 4, retired); goto done;
+        case RV32I_BLTU:  emitBranch(&e, 0x42, op, pc + 4, retired); goto done;
+        case RV32I_BGEU:  emitBranch(&e, 0x43, op, pc + 4, retired); goto done;
+        case RV32I_JAL:
+            emitStoreImm(&e, op->rd, pc + 4);
+            emit8(&e, 0xB8); emit32(&e, op->imm);                       // mov eax, target
+            emitExit(&e, retired);
+            goto done;
+        case RV32I_JALR:
+            emitEffectiveAddress(&e, op);
+            emit8(&e, 0x83); emit8(&e, 0xE0); emit8(&e, 0xFE);          // and eax, ~1
+            emitStoreImm(&e, op->rd, pc + 4);                           // rs1 already read, rd may equal rs1
+            emitExit(&e, retired);
+            goto done;
+        // Fused operations, skipping the second slot
+        case SIM_OP_LUI_ADDI:
+            emitStoreImm(&e, op->rd, op->imm);
+            emitFusionHit(&e, SIM_FUSION_LUI_ADDI);
+            op++; pc += 4;
+            break;
+        case SIM_OP_SLLI_SRLI:
+            emitAluImm(&e, 0x25, op);                                   // and eax, mask
+            emitFusionHit(&e, SIM_FUSION_SLLI_SRLI);
+            op++; pc += 4;
+            break;
+        case SIM_OP_AUIPC_JALR:
+            emitStoreImm(&e, op->rd, op->imm);
+            emitStoreImm(&e, (op + 1)->rd, pc + 8);
+            emitFusionHit(&e, SIM_FUSION_AUIPC_JALR);
+            emit8(&e, 0xB8); emit32(&e, (op->imm + (op + 1)->imm) & 0b11111111111111111111111111111110); // mov eax, target
+            emitExit(&e, retired + 1);
+            goto done;
+        case SIM_OP_CONTINUE:
+            emit8(&e, 0xB8); emit32(&e, endPc);                         // mov eax, endPc
+            emitExit(&e, retired - 1);
+            goto done;
+        default:
+            return NULL; // Checked above, not reachable
+        }
+    }
+
+done:
+    jit->used += e.pos - e.start;
+    if (mprotect(chunk, JIT_CHUNK_SIZE, PROT_READ | PROT_EXEC) != 0)
+    {
+        return NULL;    // Not executable, the block stays interpreted
+    }
+    return (sim_jit_fn_t) e.start;
+}
+
+/* Returns the chunk the next block is emitted to, made writable, with room for the largest block. Maps a new chunk
+   when the current one is full. Returns NULL when the code size is used up or the chunk cannot be mapped. */
+uint8_t* writableChunk(sim_jit_t* jit)
+{
+    uint8_t* chunk;
+
+    if (jit->current < jit->nChunks && jit->used + JIT_MAX_BLOCK_CODE > JIT_CHUNK_SIZE)
+    {
+        jit->current++;
+        jit->used = 0;
+    }
+    if (jit->current < jit->nChunks)
+    {
+        chunk = jit->chunks[jit->current];
+        return (mprotect(chunk, JIT_CHUNK_SIZE, PROT_READ | PROT_WRITE) == 0) ? chunk : NULL;
+    }
+    if (jit->nChunks == JIT_MAX_CHUNKS || jit->mapFailed)
+    {
+        return NULL;
+    }
+    chunk = mmap(NULL, JIT_CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (chunk == MAP_FAILED)
+    {
+        perror("JIT warning: Unable to allocate code memory, further blocks are interpreted");
+        jit->mapFailed = true;
+        return NULL;
+    }
+    jit->chunks[jit->nChunks++] = chunk;
+    return chunk;
+}
+
+void emit8(emitter_t* e, uint8_t byte)
+{
+    *e->pos++ = byte;
+}
+
+void emit32(emitter_t* e, uint32_t word)
+{
+    memcpy(e->pos, &word, sizeof(word));
+    e->pos += sizeof(word);
+}
+
+void emitBytes(emitter_t* e, const uint8_t* bytes, size_t n)
+{
+    memcpy(e->pos, bytes, n);
+    e->pos += n;
+}
+
+/* mov hostReg, [rbx + 4*guestReg], hostReg being 0 = eax, 1 = ecx */
+void emitLoadReg(emitter_t* e, uint8_t hostReg, uint8_t guestReg)
+{
+    emit8(e, 0x8B); emit8(e, 0x43 | (hostReg << 3)); emit8(e, guestReg * 4);
+}
+
+/* mov [rbx + 4*guestReg], eax */
+void emitStoreEax(emitter_t* e, uint8_t guestReg)
+{
+    if (guestReg != SIM_REG_DISCARD)
+    {
+        emit8(e, 0x89); emit8(e, 0x43); emit8(e, guestReg * 4);
+    }
+}
+
+/* mov dword [rbx + 4*guestReg], imm32 */
+void emitStoreImm(emitter_t* e, uint8_t guestReg, int32_t imm)
+{
+    if (guestReg != SIM_REG_DISCARD)
+    {
+        emit8(e, 0xC7); emit8(e, 0x43); emit8(e, guestReg * 4); emit32(e, imm);
+    }
+}
+
+/* eax = rs1 <op> rs2 with op eax, [rbx + 4*rs2] */
+void emitAluReg(emitter_t* e, uint8_t opcode, const sim_op_t* op)
+{
+    emitLoadReg(e, 0, op->rs1);
+    emit8(e, opcode); emit8(e, 0x43); emit8(e, op->rs2 * 4);
+    emitStoreEax(e, op->rd);
+}
+
+/* eax = rs1 <op> imm with op eax, imm32 */
+void emitAluImm(emitter_t* e, uint8_t opcode, const sim_op_t* op)
+{
+    emitLoadReg(e, 0, op->rs1);
+    emit8(e, opcode); emit32(e, op->imm);
+    emitStoreEax(e, op->rd);
+}
+
+/* x86 masks 32-bit shift counts to 5 bits, as RISC-V does */
+void emitShiftReg(emitter_t* e, uint8_t modrm, const sim_op_t* op)
+{
+    emitLoadReg(e, 0, op->rs1);
+    emitLoadReg(e, 1, op->rs2);
+    emit8(e, 0xD3); emit8(e, modrm);                                    // shl/shr/sar eax, cl
+    emitStoreEax(e, op->rd);
+}
+
+void emitShiftImm(emitter_t* e, uint8_t modrm, const sim_op_t* op)
+{
+    emitLoadReg(e, 0, op->rs1);
+    emit8(e, 0xC1); emit8(e, modrm); emit8(e, op->imm & 0b11111);      // shl/shr/sar eax, imm8
+    emitStoreEax(e, op->rd);
+}
+
+void emitSetCond(emitter_t* e, uint8_t setcc, const sim_op_t* op, bool immediate)
+{
+    emitLoadReg(e, 0, op->rs1);
+    if (immediate)
+    {
+        emit8(e, 0x3D); emit32(e, op->imm);                             // cmp eax, imm32
+    }
+    else
+    {
+        emit8(e, 0x3B); emit8(e, 0x43); emit8(e, op->rs2 * 4);          // cmp eax, [rbx + 4*rs2]
+    }
+    emit8(e, 0x0F); emit8(e, setcc); emit8(e, 0xC0);                    // setcc al
+    emit8(e, 0x0F); emit8(e, 0xB6); emit8(e, 0xC0);                     // movzx eax, al
+    emitStoreEax(e, op->rd);
+}
+
+/* eax = rs1 + imm. The 32-bit add zero extends into rax, wrapping the guest address like the guest would. */
+void emitEffectiveAddress(emitter_t* e, const sim_op_t* op)
+{
+    emitLoadReg(e, 0, op->rs1);
+    emit8(e, 0x05); emit32(e, op->imm);                                 // add eax, imm32
+}
+
+/* mov dword [r14+accessPc], pc */
+void emitAccessPc(emitter_t* e, uint32_t pc)
+{
+    emit8(e, 0x41); emit8(e, 0xC7); emit8(e, 0x46); emit8(e, CTX_ACCESS_PC); emit32(e, pc);
+}
+
+void emitLoad(emitter_t* e, const uint8_t* load, size_t n, const sim_op_t* op, uint32_t pc)
+{
+    emitAccessPc(e, pc);
+    emitEffectiveAddress(e, op);
+    emitBytes(e, load, n);
+    emitStoreEax(e, op->rd);
+}
+
+/* Store, then leave the block if any byte written lies in a word holding translated code. Only stores to a page
+   holding translated code check the words, out of the straight line path. */
+void emitStore(emitter_t* e, const uint8_t* store, size_t n, uint8_t nBytes, const sim_op_t* op, uint32_t pc, uint32_t retired)
+{
+    static const uint8_t checkPage[] = {
+        0xC1, 0xEA, CODE_PAGE_SHIFT,            // shr edx, CODE_PAGE_SHIFT
+        0x41, 0x80, 0x7C, 0x15, 0x00, 0x00,     // cmp byte [r13+rdx], 0
+    };
+    static const uint8_t checkWord[] = {
+        0xC1, 0xE9, 0x02,                       // shr ecx, 2
+        0x80, 0x3C, 0x0A, 0x00,                 // cmp byte [rdx+rcx], 0
+    };
+    uint8_t* jumpToPage[2];
+    uint8_t* jumpToWritten[2];
+    uint8_t* jumpOver[2];
+
+    emitAccessPc(e, pc);
+    emitEffectiveAddress(e, op);
+    emitLoadReg(e, 1, op->rs2);
+    emitBytes(e, store, n);
+
+    emit8(e, 0x89); emit8(e, 0xC2);                                     // mov edx, eax
+    emitBytes(e, checkPage, sizeof(checkPage));
+    emit8(e, 0x75); jumpToPage[0] = e->pos; emit8(e, 0);                // jne codePage
+    emit8(e, 0x8D); emit8(e, 0x50); emit8(e, nBytes - 1);               // lea edx, [rax + nBytes-1]
+    emitBytes(e, checkPage, sizeof(checkPage));
+    emit8(e, 0x75); jumpToPage[1] = e->pos; emit8(e, 0);                // jne codePage
+    emit8(e, 0xEB); jumpOver[0] = e->pos; emit8(e, 0);                  // jmp over
+
+    // codePage:
+    *jumpToPage[0] = e->pos - (jumpToPage[0] + 1);
+    *jumpToPage[1] = e->pos - (jumpToPage[1] + 1);
+    emit8(e, 0x49); emit8(e, 0x8B); emit8(e, 0x56); emit8(e, CTX_CODE_WORDS);  // mov rdx, [r14+codeWords]
+    emit8(e, 0x89); emit8(e, 0xC1);                                     // mov ecx, eax
+    emitBytes(e, checkWord, sizeof(checkWord));
+    emit8(e, 0x75); jumpToWritten[0] = e->pos; emit8(e, 0);             // jne codeWritten
+    emit8(e, 0x8D); emit8(e, 0x48); emit8(e, nBytes - 1);               // lea ecx, [rax + nBytes-1]
+    emitBytes(e, checkWord, sizeof(checkWord));
+    emit8(e, 0x75); jumpToWritten[1] = e->pos; emit8(e, 0);             // jne codeWritten
+    emit8(e, 0xEB); jumpOver[1] = e->pos; emit8(e, 0);                  // jmp over
+
+    // codeWritten:
+    *jumpToWritten[0] = e->pos - (jumpToWritten[0] + 1);
+    *jumpToWritten[1] = e->pos - (jumpToWritten[1] + 1);
+    emit8(e, 0x41); emit8(e, 0xC7); emit8(e, 0x46); emit8(e, CTX_CODE_WRITTEN); emit32(e, 1); // mov dword [r14+codeWritten], 1
+    emit8(e, 0xB8); emit32(e, pc + 4);                                  // mov eax, next PC
+    emitExit(e, retired);
+
+    // over:
+    *jumpOver[0] = e->pos - (jumpOver[0] + 1);
+    *jumpOver[1] = e->pos - (jumpOver[1] + 1);
+}
+
+/* Account for retired instructions and return eax */
+void emitExit(emitter_t* e, uint32_t retired)
+{
+    static const uint8_t epilogue[] = {
+        0x41, 0x5E,     // pop r14
+        0x41, 0x5D,     // pop r13
+        0x41, 0x5C,     // pop r12
+        0x5B,           // pop rbx
+        0xC3,           // ret
+    };
+
+    emit8(e, 0x49); emit8(e, 0x81); emit8(e, 0x46); emit8(e, CTX_INSTRUCT_COUNT); emit32(e, retired); // add qword [r14+instructCount], retired
+    emitBytes(e, epilogue, sizeof(epilogue));
+}
+
+/* add qword [r14 + fusionHits[fusion]], 1 */
+void emitFusionHit(emitter_t* e, sim_fusion_t fusion)
+{
+    emit8(e, 0x49); emit8(e, 0x83); emit8(e, 0x46); emit8(e, CTX_FUSION_HITS + 8 * fusion); emit8(e, 1);
+}
+
+void emitBranch(emitter_t* e, uint8_t cmovcc, const sim_op_t* op, uint32_t fallthroughPc, uint32_t retired)
+{
+    emitLoadReg(e, 0, op->rs1);
+    emit8(e, 0x3B); emit8(e, 0x43); emit8(e, op->rs2 * 4);              // cmp eax, [rbx + 4*rs2]
+    emit8(e, 0xB8); emit32(e, fallthroughPc);                           // mov eax, fallthroughPc, flags untouched
+    emit8(e, 0xB9); emit32(e, op->imm);                                 // mov ecx, target
+    emit8(e, 0x0F); emit8(e, cmovcc); emit8(e, 0xC1);                   // cmovcc eax, ecx
+    emitExit(e, retired);
+}
+
+#else // No JIT for this host
+
+sim_jit_t* simJitCreate(void)
+{
+    return NULL;
+}
+
+void simJitDestroy(sim_jit_t* jit)
+{
+    (void) jit;
+}
+
+void simJitReset(sim_jit_t* jit)
+{
+    (void) jit;
+}
+
+sim_jit_fn_t simJitCompile(sim_jit_t* jit, const sim_op_t* ops, uint32_t startPc, uint32_t endPc)
+{
+    (void) jit; (void) ops; (void) startPc; (void) endPc;
+    return NULL;
+}
+
+#endif // __x86_64__
@@ -0,0 +1,35 @@
+#ifndef SIM_JIT_H
+#define SIM_JIT_H
+#include <stdint.h>
+#include <stdbool.h>
+#include "simOp.h"
+
+/*
+Dynamic binary translator emitting native x86-64 code for blocks of micro-ops. On other hosts simJitCreate
+returns NULL and the caller keeps interpreting.
+*/
+
+/* State shared between the caller and the generated code. Field offsets are hard coded in simJit.c. */
+typedef struct sim_jit_ctx_t
+{
+    int32_t*  regFile;          // Offset  0
+    uint8_t*  prog;             // Offset  8
+    uint8_t*  codePages;        // Offset 16, non-zero for 4 KiB pages holding translated code
+    uint64_t  instructCount;    // Offset 24, incremented by the generated code
+    uint32_t  codeWritten;      // Offset 32, set when a store hit a word in codeWords
+    uint32_t  accessPc;         // Offset 36, PC of the last load or store started, where a fault is reported
+    uint8_t*  codeWords;        // Offset 40, non-zero for words holding translated code, checked in codePages only
+    uint64_t  fusionHits[SIM_FUSION_COUNT];    // Offset 48, executed fused micro-ops per pattern
+} sim_jit_ctx_t;
+
+/* Generated block. Returns the PC to continue at. */
+typedef uint32_t (*sim_jit_fn_t)(sim_jit_ctx_t* ctx);
+
+typedef struct sim_jit_t sim_jit_t;
+
+sim_jit_t*   simJitCreate(void);
+void         simJitDestroy(sim_jit_t* jit);
+void         simJitReset(sim_jit_t* jit);
+sim_jit_fn_t simJitCompile(sim_jit_t* jit, const sim_op_t* ops, uint32_t startPc, uint32_t endPc);
+
+#endif // SIM_JIT_H
@@ -0,0 +1,38 @@
+#ifndef SIM_OP_H
+#define SIM_OP_H
+#include <stdint.h>
+#include "rv32i.h"
+#include "simState.h"
+
+/*
+Micro-op produced by the block translator and consumed by the block interpreter and the JIT.
+
+A fused micro-op replaces a pair of instructions. It sits in the slot of the first instruction and the second
+instruction keeps its own slot, which is skipped at execution, so the slot index still gives the PC and the number
+of retired instructions.
+*/
+
+/* Micro-op terminating a block without a control transfer, e.g. at maximum block length */
+#define SIM_OP_CONTINUE     (RV32I_NOT_SUPPORTED - 1)
+/* Fused micro-ops */
+#define SIM_OP_LUI_ADDI     (RV32I_NOT_SUPPORTED - 2)   // rd = imm, the constant built by lui rd + addi rd, rd
+#define SIM_OP_AUIPC_JALR   (RV32I_NOT_SUPPORTED - 3)   // rd = imm as AUIPC, then the JALR in the next slot to a static target
+#define SIM_OP_SLLI_SRLI    (RV32I_NOT_SUPPORTED - 4)   // rd = rs1 & imm, zero extension by slli rd + srli rd, rd
+#define SIM_OP_FIRST        SIM_OP_SLLI_SRLI            // Lowest micro-op type
+
+/* Fusion patterns, indexing per-pattern hit counters */
+typedef enum sim_fusion_t
+{
+    SIM_FUSION_LUI_ADDI = 0, SIM_FUSION_AUIPC_JALR, SIM_FUSION_SLLI_SRLI, SIM_FUSION_COUNT,
+} sim_fusion_t;
+
+typedef struct sim_op_t
+{
+    int32_t imm;    // Immediate. Absolute target PC for branches and JAL, absolute result for AUIPC.
+    int8_t  type;   // enum rv32i_instruct_t or one of SIM_OP_*
+    uint8_t rd;     // SIM_REG_DISCARD for x0
+    uint8_t rs1;
+    uint8_t rs2;
+} sim_op_t;
+
+#endif // SIM_OP_H
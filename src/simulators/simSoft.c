@@ -1,103 +1,344 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
 #include <assert.h>
+#include <unistd.h>
 #include "simSoft.h"
 #include "rv32i.h"
+#include "flight.h"
+#include "guestMem.h"
 
 #define ERROR_MESSAGE_MAX_LENGTH (100)
 
-typedef struct inputRegs_t
+/* Decoded form of a single instruction. Filled on first execution of an address and reused afterwards. */
+typedef struct predecoded_t
 {
-    uint8_t rd;
-    uint8_t rs1;
-    uint8_t rs2;
-} inputRegs_t;
+    rv32i_decoded_t decoded;
+    uint32_t        instruct;   // Word decoded, kept for the flight recorder and traces as memory may since have changed
+    bool            valid;      // Entry decoded since allocation or since last store to the address
+    uint8_t         traceFlags; // TRACE_FLAG_* for binary trace records
+} predecoded_t;
+
+struct sim_soft_cache_t
+{
+    predecoded_t* entries;  // One per word of program memory
+    uint32_t      size;
+};
 
 typedef enum execute_return_values_t
 {
     EXECUTE_UNKNOWN = -1, EXECUTE_OK = 0, EXECUTE_ECALL_EXIT, EXECUTE_ECALL_UNSUPORTED,
 } execute_return_values_t;
 
+/* Run loops are instantiated for every combination of sim_soft_instrument_t flags. runLoop is always inlined with
+   constant flags, so each instantiation only contains the instrumentation it was instantiated for. */
+#if defined(__GNUC__)
+#define SOFT_ALWAYS_INLINE  inline __attribute__((always_inline))
+#define SOFT_NOINLINE       __attribute__((noinline))
+#else
+#define SOFT_ALWAYS_INLINE  inline
+#define SOFT_NOINLINE
+#endif
+#define SOFT_INSTRUMENTS(X) \
+    X(0) X(1) X(2)  X(3)  X(4)  X(5)  X(6)  X(7) \
+    X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15)
+
+typedef int8_t (*run_loop_t)(uint8_t* prog, uint64_t progSize, sim_state_t* state, predecoded_t* cache, uint32_t cacheSize, flight_recorder_t* flight, const sim_soft_probes_t* probes);
+
 /*** Static function prototypes ***/
-static void readInputRegisters(int32_t instruct, inputRegs_t* inputRegs);
-static enum execute_return_values_t instructionExecute(enum rv32i_instruct_t instrType, inputRegs_t* inputRegs, int32_t regFile[32], uint8_t *prog, int32_t imm, uint32_t* pcPtr);
+static SOFT_NOINLINE int8_t runCaught(uint8_t* prog, uint64_t progSize, sim_state_t* state, sim_soft_cache_t* cache, flight_recorder_t* flight, const sim_soft_probes_t* probes);
+static SOFT_ALWAYS_INLINE int8_t runLoop(uint8_t* prog, uint64_t progSize, sim_state_t* state, predecoded_t* cache, uint32_t cacheSize, flight_recorder_t* flight, const sim_soft_probes_t* probes, const unsigned instrument);
+#define X(flags) static int8_t runLoop##flags(uint8_t* prog, uint64_t progSize, sim_state_t* state, predecoded_t* cache, uint32_t cacheSize, flight_recorder_t* flight, const sim_soft_probes_t* probes);
+SOFT_INSTRUMENTS(X)
+#undef X
+static void predecode(int32_t instruct, predecoded_t* entry);
+static inline uint8_t traceFlagsOf(const rv32i_decoded_t* decoded);
+static int8_t accessFault(flight_recorder_t* flight, uint32_t adr, sim_state_t* state);
+static void invalidatePredecoded(predecoded_t* cache, uint32_t cacheSize, uint32_t adr, uint8_t nBytes);
+static SOFT_ALWAYS_INLINE enum execute_return_values_t instructionExecute(const rv32i_decoded_t* decoded, int32_t regFile[SIM_REG_COUNT + 1], uint8_t *prog, uint32_t* pcPtr, predecoded_t* cache, uint32_t cacheSize);
 static void printRegisterFile(int32_t regFile[32]);
 
-int8_t simSoftRun(uint8_t *prog, uint32_t progSize, int32_t regFile[32], int8_t verbosity)
+/* Run loop of each instrumentation, indexed by sim_soft_instrument_t flags */
+static const run_loop_t runLoops[SIM_SOFT_INSTRUMENT_COUNT] = {
+#define X(flags) [flags] = runLoop##flags,
+    SOFT_INSTRUMENTS(X)
+#undef X
+};
+
+/* Allocates a predecode cache for a program memory of progSize bytes. Returns NULL on failure. */
+sim_soft_cache_t* simSoftCacheCreate(uint64_t progSize)
+{
+    sim_soft_cache_t* cache;
+
+    // One predecode entry per word of program memory. The shadow table starts with every entry invalid, and the
+    // OS only commits the pages holding entries for executed addresses.
+    if ( (cache = malloc(sizeof(sim_soft_cache_t))) == NULL ||
+         (cache->entries = guestMemShadowCreate(progSize / 4 * sizeof(predecoded_t))) == NULL )
+    {
+        fprintf(stderr, "SoftSim error: Failed to allocate memory for predecode cache\n");
+        free(cache);
+        return NULL;
+    }
+    cache->size = progSize / 4;
+    return cache;
+}
+
+void simSoftCacheDestroy(sim_soft_cache_t* cache)
 {
-    uint32_t pc = 0;
-    int32_t instruction = 0;
-    int32_t imm = 0;
-    inputRegs_t inputRegs = {};
-    enum rv32i_instruct_t instructType;
+    if (cache != NULL)
+    {
+        guestMemShadowDestroy(cache->entries, cache->size * sizeof(predecoded_t));
+        free(cache);
+    }
+}
+
+int8_t simSoftRun(uint8_t *prog, uint64_t progSize, sim_state_t* state, const sim_soft_probes_t* probes)
+{
+    int8_t retVal;
+    sim_soft_cache_t* cache = (probes->cache != NULL) ? probes->cache : simSoftCacheCreate(progSize);
+    flight_recorder_t flight = {};
+
+    assert(probes->instrument < SIM_SOFT_INSTRUMENT_COUNT && "instrument must be a combination of sim_soft_instrument_t flags\n");
+    assert( (!(probes->instrument & SIM_SOFT_STATS) || probes->instructMix != NULL) && "instructMix must not be NULL with SIM_SOFT_STATS\n");
+    assert( (!(probes->instrument & SIM_SOFT_BINTRACE) || probes->trace != NULL) && "trace must not be NULL with SIM_SOFT_BINTRACE\n");
+
+    if (cache == NULL)
+    {
+        return -1;
+    }
+    assert(cache->size == progSize / 4 && "cache must be created for the same memory\n");
+
+    flightArm(&flight);
+    retVal = runCaught(prog, progSize, state, cache, &flight, probes);
+    flightDisarm();
+    if (retVal < 0)
+    {
+        flightDump(&flight, STDERR_FILENO);
+    }
+
+    if (probes->cache == NULL)
+    {
+        simSoftCacheDestroy(cache);
+    }
+    return retVal;
+}
+
+/* Runs the program from state->pc with the run loop of the probes. Kept out of line, and the flight recorder read
+   after a fault is the caller's, so no local changed after sigsetjmp is read after it. */
+int8_t runCaught(uint8_t* prog, uint64_t progSize, sim_state_t* state, sim_soft_cache_t* cache, flight_recorder_t* flight, const sim_soft_probes_t* probes)
+{
+    int8_t retVal;
+    guest_mem_fault_t fault;
+
+    // Loads and stores are not bounds checked, a bad guest address faults and returns here
+    guestMemArm(&fault, prog);
+    if (sigsetjmp(fault.env, 1) != 0)
+    {
+        retVal = accessFault(flight, fault.adr, state);
+    }
+    else
+    {
+        retVal = runLoops[probes->instrument](prog, progSize, state, cache->entries, cache->size, flight, probes);
+    }
+    guestMemDisarm();
+    return retVal;
+}
+
+#define X(flags) \
+int8_t runLoop##flags(uint8_t* prog, uint64_t progSize, sim_state_t* state, predecoded_t* cache, uint32_t cacheSize, flight_recorder_t* flight, const sim_soft_probes_t* probes) \
+{ \
+    return runLoop(prog, progSize, state, cache, cacheSize, flight, probes, flags); \
+}
+SOFT_INSTRUMENTS(X)
+#undef X
+
+int8_t runLoop(uint8_t* prog, uint64_t progSize, sim_state_t* state, predecoded_t* cache, uint32_t cacheSize, flight_recorder_t* flight, const sim_soft_probes_t* probes, const unsigned instrument)
+{
+    int32_t* regFile = state->regFile;
+    uint32_t pc = state->pc;
+    uint64_t count = 0;
+    uint64_t budget = UINT64_MAX;   // Instructions left before the limit
+    int8_t retVal = 0;
+    bool running = true;
+    predecoded_t* entry = NULL;
     enum execute_return_values_t executeReturnVal;
+    uint32_t instructPc;
+    uint32_t traceAdr = 0;
+    flight_record_t* record;
 
-    while (pc < progSize)
+    if (probes->instructLimit != 0)
     {
-        /* IF: Instruction Fetch */
-        instruction = rv32iLoadWord(prog+pc);
-        pc += 4;
+        budget = (probes->instructLimit > state->instructCount) ? probes->instructLimit - state->instructCount : 0;
+    }
 
-        /* ID: Instruction Decode*/
-        instructType = rv32iDecodeInstructType(instruction);
-        if (instructType == RV32I_NOT_SUPPORTED)
+    while (running && pc < progSize && count < budget)
+    {
+        /* IF, ID: Instruction Fetch and Decode, served from the predecode cache after first execution */
+        if (pc & 0b11)
+        {
+            fprintf(stderr, "SoftSim error: Jump to misaligned PC = %d\n", pc);
+            retVal = SIM_RUN_FAULT; // As in the other engines, which only dispatch word aligned entries
+            break;
+        }
+        entry = &cache[pc >> 2];
+        if (!entry->valid)
         {
-            fprintf(stderr, "SoftSim error: Decoder encountered unsuported instruction 0x%08x at PC = %d\n", instruction, (pc-4));
-            return -1; // TODO: Reconsider error handling at unsuported instruction
+            predecode(rv32iLoadWord(prog+pc), entry);
         }
-        readInputRegisters(instruction, &inputRegs);
-        imm = rv32iGenerateImmediate(instruction);
+        if (entry->decoded.type == RV32I_NOT_SUPPORTED)
+        {
+            fprintf(stderr, "SoftSim error: Decoder encountered unsuported instruction 0x%08x at PC = %d\n", entry->instruct, pc);
+            retVal = -1; // TODO: Reconsider error handling at unsuported instruction
+            break;
+        }
+        instructPc = pc;
+        // Always recorded, before execution so that a fault is attributed to the faulting instruction
+        record = flightRecord(flight, count + 1, instructPc, entry->instruct);
+        pc += 4;
 
-        if (verbosity)
+        if (instrument & SIM_SOFT_TRACE)
+        {
+            fprintf(stderr, ">>>SoftSim: Instruction type %d with value 0x%08x at PC = %d\n",(uint8_t) entry->decoded.type, entry->instruct, instructPc);
+            fprintf(stderr, "imm = %d\n", entry->decoded.imm);
+        }
+        if (instrument & SIM_SOFT_STATS)
         {
-            fprintf(stderr, ">>>SoftSim: Instruction type %d with value 0x%08x at PC = %d\n",(uint8_t) instructType, instruction, (pc-4));
-            fprintf(stderr, "imm = %d\n", imm);
+            probes->instructMix[entry->decoded.type]++;
+        }
+        if (instrument & SIM_SOFT_BINTRACE)
+        {
+            traceAdr = simAddress(regFile[entry->decoded.rs1], entry->decoded.imm); // Before a load may overwrite rs1
         }
 
         /* EX, MEM, WB: Execute, Memory, Write back */
-        executeReturnVal = instructionExecute(instructType, &inputRegs, regFile, prog, imm, &pc);
+        executeReturnVal = instructionExecute(&entry->decoded, regFile, prog, &pc, cache, cacheSize);
+        count++;
+        record->rdValue = regFile[entry->decoded.rd];   // Only meaningful when rd was written, but free of branches
+        if (instrument & SIM_SOFT_BINTRACE)
+        {
+            *traceRecord(probes->trace) = (trace_record_t) {
+                .pc       = instructPc,
+                .instruct = entry->instruct,
+                .rdValue  = (entry->traceFlags & TRACE_FLAG_WRITE) ? regFile[entry->decoded.rd] : 0,
+                .memAdr   = (entry->traceFlags & (TRACE_FLAG_LOAD | TRACE_FLAG_STORE)) ? traceAdr : 0,
+                .rd       = (entry->traceFlags & TRACE_FLAG_WRITE) ? entry->decoded.rd : 0,
+                .flags    = entry->traceFlags,
+            };
+        }
         switch (executeReturnVal)
         {
         case EXECUTE_OK:
             break;
         case EXECUTE_ECALL_EXIT:
-            if (verbosity)
+            if (instrument & SIM_SOFT_TRACE)
             {
                 fprintf(stderr, "SoftSim: ECALL exit at PC = %d\n", (pc-4));
             }
-            return 0;
+            running = false;
+            break;
         case EXECUTE_ECALL_UNSUPORTED:
             fprintf(stderr, "SoftSim error: Unsuported ECALL with argument a7 = %d at PC = %d\n", regFile[17], (pc-4));
-            return -1;
+            retVal = -1;
+            running = false;
+            break;
         case EXECUTE_UNKNOWN: // Fallthrough
         default:
             fprintf(stderr, "SoftSim error: Unknown instructExecute command at PC = %d\n", (pc-4));
             assert(0); // Should not exist
-            return -1;
+            retVal = -1;
+            running = false;
+            break;
         }
-        if (verbosity)
+        if ( (instrument & SIM_SOFT_REGDUMP) && running )
         {
             printRegisterFile(regFile);
         }
     }
 
-    return 0;
+    if (running && count == budget)
+    {
+        retVal = SIM_RUN_LIMIT;
+    }
+    state->pc = pc;
+    state->instructCount += count;
+    return retVal;
+}
+
+/* Reports a faulting load or store. The run loop state is lost, the faulting instruction is the newest flight
+   recorder record, so the state is left at it with the instructions before it counted. */
+int8_t accessFault(flight_recorder_t* flight, uint32_t adr, sim_state_t* state)
+{
+    const flight_record_t* record = flightNewest(flight);
+
+    if (record != NULL)
+    {
+        flight->interrupted   = true;
+        state->pc             = record->pc;
+        state->instructCount += record->seq - 1;
+    }
+    fprintf(stderr, "SoftSim error: Access fault at address 0x%08x by instruction at PC = %d\n", adr, state->pc);
+    return SIM_RUN_FAULT;
+}
+
+void predecode(int32_t instruct, predecoded_t* entry)
+{
+    entry->decoded  = rv32iDecode(instruct);
+    entry->instruct = instruct;
+    entry->valid    = true;
+    if (entry->decoded.rd == 0)
+    {
+        entry->decoded.rd = SIM_REG_DISCARD;  // x0 is hardwired to 0. Instructions changing it are effectively NOPs.
+    }
+    entry->traceFlags = traceFlagsOf(&entry->decoded);
+}
+
+/* Binary trace flags of an instruction. rd is written by all formats but S and B, unless it is x0. */
+uint8_t traceFlagsOf(const rv32i_decoded_t* decoded)
+{
+    uint8_t flags = 0;
+
+    if (decoded->format != RV32I_OPCODE_TYPE_S && decoded->format != RV32I_OPCODE_TYPE_B && decoded->rd != SIM_REG_DISCARD)
+    {
+        flags |= TRACE_FLAG_WRITE;
+    }
+    switch (decoded->type)
+    {
+    case RV32I_LB:  // Fallthrough
+    case RV32I_LH:  // Fallthrough
+    case RV32I_LW:  // Fallthrough
+    case RV32I_LBU: // Fallthrough
+    case RV32I_LHU:
+        flags |= TRACE_FLAG_LOAD;
+        break;
+    case RV32I_SB:  // Fallthrough
+    case RV32I_SH:  // Fallthrough
+    case RV32I_SW:
+        flags |= TRACE_FLAG_STORE;
+        break;
+    default:
+        break;
+    }
+    return flags;
 }
 
-void readInputRegisters(int32_t instruct, inputRegs_t* inputRegs)
+// Stores may overwrite instructions. Drop the predecoded entry of every word touched by a store.
+void invalidatePredecoded(predecoded_t* cache, uint32_t cacheSize, uint32_t adr, uint8_t nBytes)
 {
-    inputRegs->rs1 = rv32iGetRs1(instruct);
-    inputRegs->rs2 = rv32iGetRs2(instruct);
-    inputRegs->rd  = rv32iGetRd( instruct);
+    for (uint32_t i = adr >> 2; i <= (adr + nBytes - 1) >> 2 && i < cacheSize; i++)
+    {
+        cache[i].valid = false;
+    }
 }
 
-// TODO: Consider making regFile static variable in this file and have a copy function to return it to caller
-enum execute_return_values_t instructionExecute(enum rv32i_instruct_t instrType, inputRegs_t* inputRegs, int32_t regFile[32], uint8_t *prog, int32_t imm, uint32_t* pcPtr)
+enum execute_return_values_t instructionExecute(const rv32i_decoded_t* decoded, int32_t regFile[SIM_REG_COUNT + 1], uint8_t *prog, uint32_t* pcPtr, predecoded_t* cache, uint32_t cacheSize)
 {
-    uint8_t rd  = inputRegs->rd;
-    uint8_t rs1 = inputRegs->rs1;
-    uint8_t rs2 = inputRegs->rs2;
+    uint8_t rd  = decoded->rd;
+    uint8_t rs1 = decoded->rs1;
+    uint8_t rs2 = decoded->rs2;
+    int32_t imm = decoded->imm;
+    uint32_t target;
     enum execute_return_values_t returnVal = EXECUTE_OK;
-    switch (instrType)
+    switch (decoded->type)
     {
     // ALU operations
     case RV32I_ADD:
@@ -212,25 +453,25 @@ enum execute_return_values_t instructionExecute(enum rv32i_instruct_t instrType,
         *pcPtr = (*pcPtr - 4) + imm;
         break;
     case RV32I_JALR:
-        regFile[rd] = *pcPtr; // Current instruction + 4
-        *pcPtr = (regFile[rs1] + imm) & 0b11111111111111111111111111111110; // Mask away LS bit as specified in RISC-V Instruction Set Manual
+        target = (regFile[rs1] + imm) & 0b11111111111111111111111111111110; // Mask away LS bit as specified in RISC-V Instruction Set Manual
+        regFile[rd] = *pcPtr; // Current instruction + 4, written after rs1 is read as they may be equal
+        *pcPtr = target;
         break;
     // Load operations
     case RV32I_LB:
-        regFile[rd] = rv32iSignExtentByte( rv32iLoadByte(prog + regFile[rs1] + imm));
+        regFile[rd] = rv32iSignExtentByte( rv32iLoadByte(prog + simAddress(regFile[rs1], imm)));
         break;
     case RV32I_LH:
-        // TODO: Account for endianess - For now little endian is assumed
-        regFile[rd] = rv32iSignExtentHalfWord( rv32iLoadHalfWord(prog + regFile[rs1] + imm) );
+        regFile[rd] = rv32iSignExtentHalfWord( rv32iLoadHalfWord(prog + simAddress(regFile[rs1], imm)) );
         break;
     case RV32I_LW:
-        regFile[rd] = rv32iLoadWord(prog + regFile[rs1] + imm);
+        regFile[rd] = rv32iLoadWord(prog + simAddress(regFile[rs1], imm));
         break;
     case RV32I_LBU:
-        regFile[rd] = rv32iLoadByte(prog + regFile[rs1] + imm);
+        regFile[rd] = rv32iLoadByte(prog + simAddress(regFile[rs1], imm));
         break;
     case RV32I_LHU:
-        regFile[rd] = rv32iLoadHalfWord(prog + regFile[rs1] + imm);
+        regFile[rd] = rv32iLoadHalfWord(prog + simAddress(regFile[rs1], imm));
         break;
     // Upper immediates operations
     case RV32I_LUI:
@@ -241,21 +482,22 @@ enum execute_return_values_t instructionExecute(enum rv32i_instruct_t instrType,
         break;
     // Store operations
     case RV32I_SB:
-        rv32iStoreByte(prog + regFile[rs1] + imm, regFile[rs2]);
+        rv32iStoreByte(prog + simAddress(regFile[rs1], imm), regFile[rs2]);
+        invalidatePredecoded(cache, cacheSize, simAddress(regFile[rs1], imm), 1);
         break;
     case RV32I_SH:
-        rv32iStoreHalfWord(prog+regFile[rs1]+imm, regFile[rs2]);
+        rv32iStoreHalfWord(prog + simAddress(regFile[rs1], imm), regFile[rs2]);
+        invalidatePredecoded(cache, cacheSize, simAddress(regFile[rs1], imm), 2);
         break;
     case RV32I_SW:
-        rv32iStoreWord(prog+regFile[rs1]+imm, regFile[rs2]);
+        rv32iStoreWord(prog + simAddress(regFile[rs1], imm), regFile[rs2]);
+        invalidatePredecoded(cache, cacheSize, simAddress(regFile[rs1], imm), 4);
         break;
     default:
         returnVal = EXECUTE_UNKNOWN;
         break;
     };
 
-    regFile[0] = 0; // x0 is hardwired to 0. Instructions changing it are effectively NOPs.
-
     return returnVal;
 }
 
@@ -1,7 +1,38 @@
 #ifndef SIM_SOFT_H
 #define SIM_SOFT_H
 #include <stdint.h>
+#include "simState.h"
+#include "rv32i.h"
+#include "trace.h"
 
-int8_t simSoftRun(uint8_t* prog, uint32_t progSize, int32_t regFile[32], int8_t verbosity);
+/* Instrumentation flags of a run. Every combination has its own run loop specialized at compile time, so a run
+   without instrumentation executes no instrumentation branches. */
+typedef enum sim_soft_instrument_t
+{
+    SIM_SOFT_PLAIN   = 0,
+    SIM_SOFT_TRACE   = 1 << 0,  // Print every instruction
+    SIM_SOFT_REGDUMP = 1 << 1,  // Print the register file after every instruction
+    SIM_SOFT_STATS   = 1 << 2,  // Count executed instructions per type in instructMix
+    SIM_SOFT_BINTRACE = 1 << 3, // Write a binary trace record per instruction to trace
+    SIM_SOFT_INSTRUMENT_COUNT = 1 << 4,
+} sim_soft_instrument_t;
+
+/* Predecoded instructions of one program memory, kept between runs so a run resumed after an instruction limit does
+   not decode its instructions again */
+typedef struct sim_soft_cache_t sim_soft_cache_t;
+
+/* Instrumentation of a run and the data it collects */
+typedef struct sim_soft_probes_t
+{
+    unsigned  instrument;   // Combination of sim_soft_instrument_t flags
+    uint64_t* instructMix;  // SIM_SOFT_STATS: executed instructions per type, RV32I_INSTRUCT_COUNT entries
+    trace_t*  trace;        // SIM_SOFT_BINTRACE: open binary trace
+    uint64_t  instructLimit;// Stop with SIM_RUN_LIMIT once state->instructCount reaches this, 0 for no limit
+    sim_soft_cache_t* cache;// Cache created for progSize, or NULL for one that only lives for this run
+} sim_soft_probes_t;
+
+sim_soft_cache_t* simSoftCacheCreate (uint64_t progSize);
+void              simSoftCacheDestroy(sim_soft_cache_t* cache);
+int8_t            simSoftRun(uint8_t* prog, uint64_t progSize, sim_state_t* state, const sim_soft_probes_t* probes);
 
 #endif // SIM_SOFT_H
@@ -0,0 +1,35 @@
+#ifndef SIM_STATE_H
+#define SIM_STATE_H
+#include <stdint.h>
+
+/*
+Architectural state shared by all simulator engines.
+
+Engines run programs in guest memory of progSize bytes, at most the full 32-bit address space, which is why sizes
+are passed as uint64_t.
+
+x0 is hardwired to 0 without any per-instruction work. Engines redirect a destination register of x0 to the
+discard slot when an instruction is predecoded, so regFile[0] is never written and reads of x0 always see 0.
+*/
+
+#define SIM_REG_COUNT       (32)            // Architectural registers x0 - x31
+#define SIM_REG_DISCARD     (SIM_REG_COUNT) // Register file slot receiving writes to x0
+#define SIM_RUN_LIMIT       (1)             // Run return value when stopped at the instruction limit, before an exit
+#define SIM_RUN_FAULT       (-2)            // Run return value after a guest access fault or a jump to a misaligned PC,
+                                            // which leave no meaningful register file. Other errors return -1.
+
+typedef struct sim_state_t
+{
+    int32_t  regFile[SIM_REG_COUNT + 1];    // x0 - x31 followed by the discard slot
+    uint32_t pc;                            // Next instruction to execute. Engines start here and leave the final PC.
+    uint64_t instructCount;                 // Executed instructions, accumulated across runs
+} sim_state_t;
+
+/* Guest address of a load or store. The sum wraps in the 32-bit address space as on hardware, which keeps every
+   access within the guest memory reservation. */
+static inline uint32_t simAddress(int32_t base, int32_t offset)
+{
+    return (uint32_t) base + (uint32_t) offset;
+}
+
+#endif // SIM_STATE_H
@@ -0,0 +1,374 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include "simThreaded.h"
+#include "rv32i.h"
+#include "guestMem.h"
+#include "flight.h"
+
+/*
+Direct-threaded execution engine. Every program word gets a predecoded entry naming its handler, and each
+handler ends by jumping straight to the handler of the next entry. With GCC and Clang the jump is a computed
+goto (labels as values), so every handler owns its own indirect branch which the branch predictor can learn
+separately. Other compilers, or builds defining SIM_THREADED_PORTABLE, use a switch in a loop instead.
+
+Loads and stores are not bounds checked, a bad guest access faults and returns to simThreadedRun. The run keeps its
+PC and instruction count in registers, and only loads and stores write them to the state first, so a faulted run is
+left at the faulting instruction with the instructions before it counted. The run loop is kept out of line, as the
+locals of the function calling sigsetjmp are kept in memory.
+
+The flight recorder gets a record for every jump target entered, as recording every instruction would cost the
+handlers more than they do. A failed run dumps it.
+
+An instruction limit is checked where control transfers are taken, so a run stops at the first jump target at or
+beyond it, and straight-line code pays nothing for it.
+*/
+#if defined(__GNUC__) && !defined(SIM_THREADED_PORTABLE)
+#define SIM_THREADED_COMPUTED_GOTO
+#endif
+#if defined(__GNUC__)
+#define THREADED_NOINLINE   __attribute__((noinline))
+#else
+#define THREADED_NOINLINE
+#endif
+
+/* One handler per supported rv32i instruction */
+#define THREADED_INSTRUCTS(X) \
+    X(ADD)  X(ADDI) X(AND)  X(ANDI) X(AUIPC) X(BEQ)  X(BGE)  X(BGEU) X(BLT)  X(BLTU) X(BNE)  X(ECALL) X(JAL) \
+    X(JALR) X(LB)   X(LBU)  X(LH)   X(LHU)   X(LUI)  X(LW)   X(OR)   X(ORI)  X(SB)   X(SH)   X(SLL)   X(SLLI) \
+    X(SLT)  X(SLTI) X(SLTIU) X(SLTU) X(SRA)  X(SRAI) X(SRL)  X(SRLI) X(SUB)  X(SW)   X(XOR)  X(XORI)
+
+/* Handler selector. OP_DECODE is zero, so a zero filled cache decodes every word on first execution. */
+typedef enum threaded_op_t
+{
+    OP_DECODE = 0, OP_NOT_SUPPORTED,
+#define X(name) OP_##name,
+    THREADED_INSTRUCTS(X)
+#undef X
+} threaded_op_t;
+
+/* Predecoded entry. Control transfer targets are resolved to absolute PCs at decode time. */
+typedef struct threaded_t
+{
+    int32_t handler;    // Computed goto: offset of the handler label from the decode label. Portable: threaded_op_t
+    int32_t imm;        // Immediate. Absolute target PC for branches and JAL, absolute result for AUIPC.
+    uint8_t rd;
+    uint8_t rs1;
+    uint8_t rs2;
+} threaded_t;
+
+static const uint8_t opOfInstruct[] = {
+#define X(name) [RV32I_##name] = OP_##name,
+    THREADED_INSTRUCTS(X)
+#undef X
+};
+
+struct sim_threaded_cache_t
+{
+    threaded_t* entries;    // One per program word plus a sentinel past the end, whose decode handler ends the run
+    uint32_t    size;       // Program words
+    uint64_t    progSize;
+};
+
+/*** Static function prototypes ***/
+static THREADED_NOINLINE int8_t runCaught(uint8_t* prog, uint64_t progSize, sim_state_t* state, sim_threaded_cache_t* cache, flight_recorder_t* flight, uint64_t instructLimit);
+static THREADED_NOINLINE int8_t runThreaded(uint8_t* prog, uint64_t progSize, sim_state_t* state, threaded_t* cache, uint32_t cacheSize, flight_recorder_t* flight, uint64_t instructLimit);
+static threaded_op_t predecode(int32_t instruct, uint32_t pc, threaded_t* entry);
+static inline void invalidateThreaded(threaded_t* cache, uint32_t cacheSize, uint32_t adr, uint8_t nBytes);
+
+/* Allocates a predecode cache for a program memory of progSize bytes. Returns NULL on failure. */
+sim_threaded_cache_t* simThreadedCacheCreate(uint64_t progSize)
+{
+    sim_threaded_cache_t* cache;
+
+    if ( (cache = malloc(sizeof(sim_threaded_cache_t))) == NULL ||
+         (cache->entries = guestMemShadowCreate(((progSize + 3) / 4 + 1) * sizeof(threaded_t))) == NULL )
+    {
+        fprintf(stderr, "ThreadedSim error: Failed to allocate memory for predecode cache\n");
+        free(cache);
+        return NULL;
+    }
+    cache->size     = (progSize + 3) / 4;
+    cache->progSize = progSize;
+    return cache;
+}
+
+void simThreadedCacheDestroy(sim_threaded_cache_t* cache)
+{
+    if (cache != NULL)
+    {
+        guestMemShadowDestroy(cache->entries, (cache->size + 1) * sizeof(threaded_t));
+        free(cache);
+    }
+}
+
+int8_t simThreadedRun(uint8_t* prog, uint64_t progSize, sim_state_t* state, uint64_t instructLimit, sim_threaded_cache_t* kept)
+{
+    int8_t retVal;
+    sim_threaded_cache_t* cache = (kept != NULL) ? kept : simThreadedCacheCreate(progSize);
+    flight_recorder_t flight = { .blocks = true };
+
+    if (cache == NULL)
+    {
+        return -1;
+    }
+    assert(cache->progSize == progSize && "cache must be created for the same memory\n");
+
+    flightArm(&flight);
+    retVal = runCaught(prog, progSize, state, cache, &flight, instructLimit);
+    flightDisarm();
+    if (retVal < 0)
+    {
+        flightDump(&flight, STDERR_FILENO);
+    }
+
+    if (kept == NULL)
+    {
+        simThreadedCacheDestroy(cache);
+    }
+    return retVal;
+}
+
+/* Runs the program from state->pc, reporting a guest access fault as an error */
+int8_t runCaught(uint8_t* prog, uint64_t progSize, sim_state_t* state, sim_threaded_cache_t* cache, flight_recorder_t* flight, uint64_t instructLimit)
+{
+    int8_t retVal;
+    guest_mem_fault_t fault;
+
+    guestMemArm(&fault, prog);
+    if (sigsetjmp(fault.env, 1) != 0)
+    {
+        fprintf(stderr, "ThreadedSim error: Access fault at address 0x%08x by instruction at PC = %d\n", fault.adr, state->pc);
+        flight->interrupted = true;
+        retVal = SIM_RUN_FAULT;
+    }
+    else
+    {
+        retVal = runThreaded(prog, progSize, state, cache->entries, cache->size, flight, instructLimit);
+    }
+    guestMemDisarm();
+    return retVal;
+}
+
+int8_t runThreaded(uint8_t* prog, uint64_t progSize, sim_state_t* state, threaded_t* cache, uint32_t cacheSize, flight_recorder_t* flight, uint64_t instructLimit)
+{
+    int8_t retVal = 0;
+    uint64_t count = 0;
+    uint64_t entries = 0;           // Jump targets entered, numbering the flight records
+    const uint64_t startCount = state->instructCount;
+    uint64_t budget = UINT64_MAX;   // Instructions left before the limit
+    int32_t* regFile = state->regFile;
+    uint32_t target = state->pc;
+    threaded_t* ip = NULL;
+
+#ifdef SIM_THREADED_COMPUTED_GOTO
+    static const int32_t handlers[] = {
+        [OP_DECODE]        = &&op_DECODE        - &&op_DECODE,
+        [OP_NOT_SUPPORTED] = &&op_NOT_SUPPORTED - &&op_DECODE,
+#define X(name) [OP_##name] = &&op_##name - &&op_DECODE,
+        THREADED_INSTRUCTS(X)
+#undef X
+    };
+#define HANDLER(name)   op_##name
+#define HANDLER_OF(op)  handlers[op]
+#define DISPATCH()      goto *(&&op_DECODE + ip->handler)
+#else
+#define HANDLER(name)   case OP_##name
+#define HANDLER_OF(op)  (op)
+#define DISPATCH()      goto dispatch
+#endif
+
+#define PC_OF(entry)    ( (uint32_t) ((entry) - cache) << 2 )
+#define RD              regFile[ip->rd]
+#define RS1             regFile[ip->rs1]
+#define RS2             regFile[ip->rs2]
+#define NEXT()          do { count++; ip++; DISPATCH(); } while (0)
+#define JUMP(pcTarget)  do { target = (pcTarget); goto jump; } while (0)
+#define ACCESS()        ( state->pc = PC_OF(ip), state->instructCount = startCount + count )    // Where a fault is reported
+
+    if (instructLimit != 0)
+    {
+        budget = (instructLimit > state->instructCount) ? instructLimit - state->instructCount : 0;
+    }
+    goto enter;
+
+#ifndef SIM_THREADED_COMPUTED_GOTO
+dispatch:
+    switch (ip->handler)
+    {
+#endif
+
+    HANDLER(DECODE):
+        if (PC_OF(ip) >= progSize)
+        {
+            state->pc = PC_OF(ip);
+            goto done;  // Ran past end of program memory
+        }
+        ip->handler = HANDLER_OF(predecode(rv32iLoadWord(prog + PC_OF(ip)), PC_OF(ip), ip));
+        DISPATCH();
+    HANDLER(NOT_SUPPORTED):
+        fprintf(stderr, "ThreadedSim error: Decoder encountered unsuported instruction 0x%08x at PC = %d\n", rv32iLoadWord(prog + PC_OF(ip)), PC_OF(ip));
+        state->pc = PC_OF(ip);
+        retVal = -1;
+        goto done;
+
+    // ALU operations
+    HANDLER(ADD):   RD = RS1 + RS2; NEXT();
+    HANDLER(SUB):   RD = RS1 - RS2; NEXT();
+    HANDLER(SLL):   RD = RS1 << (RS2 & 0b11111); NEXT();
+    HANDLER(SLT):   RD = (RS1 < RS2) ? 1 : 0; NEXT();
+    HANDLER(SLTU):  RD = ( (uint32_t) RS1 < (uint32_t) RS2) ? 1 : 0; NEXT();
+    HANDLER(XOR):   RD = RS1 ^ RS2; NEXT();
+    HANDLER(SRL):   RD = (uint32_t) RS1 >> (RS2 & 0b11111); NEXT();
+    HANDLER(SRA):   RD = RS1 >> (RS2 & 0b11111); NEXT();
+    HANDLER(OR):    RD = RS1 | RS2; NEXT();
+    HANDLER(AND):   RD = RS1 & RS2; NEXT();
+    // ALU immediate operations
+    HANDLER(ADDI):  RD = RS1 + ip->imm; NEXT();
+    HANDLER(SLTI):  RD = (RS1 < ip->imm) ? 1 : 0; NEXT();
+    HANDLER(SLTIU): RD = ( (uint32_t) RS1 < (uint32_t) ip->imm) ? 1 : 0; NEXT();
+    HANDLER(XORI):  RD = RS1 ^ ip->imm; NEXT();
+    HANDLER(ORI):   RD = RS1 | ip->imm; NEXT();
+    HANDLER(ANDI):  RD = RS1 & ip->imm; NEXT();
+    HANDLER(SLLI):  RD = RS1 << (ip->imm & 0b11111); NEXT();
+    HANDLER(SRLI):  RD = (uint32_t) RS1 >> (ip->imm & 0b11111); NEXT();
+    HANDLER(SRAI):  RD = RS1 >> (ip->imm & 0b11111); NEXT();
+    // Branch operations
+    HANDLER(BEQ):   if (RS1 == RS2) JUMP(ip->imm); NEXT();
+    HANDLER(BNE):   if (RS1 != RS2) JUMP(ip->imm); NEXT();
+    HANDLER(BLT):   if (RS1 <  RS2) JUMP(ip->imm); NEXT();
+    HANDLER(BGE):   if (RS1 >= RS2) JUMP(ip->imm); NEXT();
+    HANDLER(BLTU):  if ( (uint32_t) RS1 <  (uint32_t) RS2) JUMP(ip->imm); NEXT();
+    HANDLER(BGEU):  if ( (uint32_t) RS1 >= (uint32_t) RS2) JUMP(ip->imm); NEXT();
+    // Environment operations
+    HANDLER(ECALL):
+        count++;
+        state->pc = PC_OF(ip) + 4;
+        if (regFile[17] != 10) // ECALL exit at a7 = 10 defined in assignment specification
+        {
+            fprintf(stderr, "ThreadedSim error: Unsuported ECALL with argument a7 = %d at PC = %d\n", regFile[17], PC_OF(ip));
+            retVal = -1;
+        }
+        goto done;
+    // Jump operations
+    HANDLER(JAL):
+        RD = PC_OF(ip) + 4;
+        JUMP(ip->imm);
+    HANDLER(JALR):
+        target = (RS1 + ip->imm) & 0b11111111111111111111111111111110; // Read rs1 before rd is written, they may be equal
+        RD = PC_OF(ip) + 4;
+        goto jump;
+    // Load operations
+    HANDLER(LB):    ACCESS(); RD = rv32iSignExtentByte(rv32iLoadByte(prog + simAddress(RS1, ip->imm))); NEXT();
+    HANDLER(LH):    ACCESS(); RD = rv32iSignExtentHalfWord(rv32iLoadHalfWord(prog + simAddress(RS1, ip->imm))); NEXT();
+    HANDLER(LW):    ACCESS(); RD = rv32iLoadWord(prog + simAddress(RS1, ip->imm)); NEXT();
+    HANDLER(LBU):   ACCESS(); RD = rv32iLoadByte(prog + simAddress(RS1, ip->imm)); NEXT();
+    HANDLER(LHU):   ACCESS(); RD = rv32iLoadHalfWord(prog + simAddress(RS1, ip->imm)); NEXT();
+    // Upper immediates operations
+    HANDLER(LUI):   // Fallthrough, AUIPC immediate is absolute
+    HANDLER(AUIPC): RD = ip->imm; NEXT();
+    // Store operations
+    HANDLER(SB):
+        ACCESS();
+        rv32iStoreByte(prog + simAddress(RS1, ip->imm), RS2);
+        invalidateThreaded(cache, cacheSize, simAddress(RS1, ip->imm), 1);
+        NEXT();
+    HANDLER(SH):
+        ACCESS();
+        rv32iStoreHalfWord(prog + simAddress(RS1, ip->imm), RS2);
+        invalidateThreaded(cache, cacheSize, simAddress(RS1, ip->imm), 2);
+        NEXT();
+    HANDLER(SW):
+        ACCESS();
+        rv32iStoreWord(prog + simAddress(RS1, ip->imm), RS2);
+        invalidateThreaded(cache, cacheSize, simAddress(RS1, ip->imm), 4);
+        NEXT();
+
+#ifndef SIM_THREADED_COMPUTED_GOTO
+    }
+#endif
+
+jump:
+    count++;
+enter:
+    if (target >= progSize)
+    {
+        state->pc = target;
+        goto done;  // Jumped past end of program memory
+    }
+    if (target & 0b11)
+    {
+        state->pc = target;
+        fprintf(stderr, "ThreadedSim error: Jump to misaligned PC = %d\n", target);
+        retVal = SIM_RUN_FAULT;
+        goto done;
+    }
+    if (count >= budget)
+    {
+        state->pc = target;
+        retVal = SIM_RUN_LIMIT;
+        goto done;
+    }
+    flightRecord(flight, ++entries, target, rv32iLoadWord(prog + target));
+    ip = &cache[target >> 2];
+    DISPATCH();
+
+done:
+    state->instructCount = startCount + count;
+    return retVal;
+
+#undef HANDLER
+#undef HANDLER_OF
+#undef DISPATCH
+#undef PC_OF
+#undef RD
+#undef RS1
+#undef RS2
+#undef NEXT
+#undef JUMP
+#undef ACCESS
+}
+
+threaded_op_t predecode(int32_t instruct, uint32_t pc, threaded_t* entry)
+{
+    rv32i_decoded_t decoded = rv32iDecode(instruct);
+
+    entry->rd  = (decoded.rd == 0) ? SIM_REG_DISCARD : decoded.rd; // x0 is hardwired to 0, writes to it are discarded
+    entry->rs1 = decoded.rs1;
+    entry->rs2 = decoded.rs2;
+    entry->imm = decoded.imm;
+
+    switch (decoded.type)
+    {
+    case RV32I_NOT_SUPPORTED:
+        return OP_NOT_SUPPORTED;
+    case RV32I_BEQ:  // Fallthrough
+    case RV32I_BNE:  // Fallthrough
+    case RV32I_BLT:  // Fallthrough
+    case RV32I_BGE:  // Fallthrough
+    case RV32I_BLTU: // Fallthrough
+    case RV32I_BGEU: // Fallthrough
+    case RV32I_JAL:  // Fallthrough
+    case RV32I_AUIPC:
+        entry->imm += pc;
+        break;
+    default:
+        break;
+    }
+
+    return opOfInstruct[decoded.type];
+}
+
+// Stores may overwrite instructions. Send every word touched by a store back through the decode handler.
+void invalidateThreaded(threaded_t* cache, uint32_t cacheSize, uint32_t adr, uint8_t nBytes)
+{
+    if ( (adr >> 2) < cacheSize )
+    {
+        cache[adr >> 2].handler = 0;
+    }
+    if ( ((adr + nBytes - 1) >> 2) < cacheSize )
+    {
+        cache[(adr + nBytes - 1) >> 2].handler = 0;
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef SIM_THREADED_H
+#define SIM_THREADED_H
+#include <stdint.h>
+#include "simState.h"
+
+/* Predecoded entries of one program memory, kept between runs so a run resumed after an instruction limit does not
+   decode its instructions again */
+typedef struct sim_threaded_cache_t sim_threaded_cache_t;
+
+sim_threaded_cache_t* simThreadedCacheCreate (uint64_t progSize);
+void                  simThreadedCacheDestroy(sim_threaded_cache_t* cache);
+
+/* instructLimit stops the run with SIM_RUN_LIMIT at the first jump target where state->instructCount has reached it,
+   0 for no limit. cache is a cache created for progSize, or NULL for one that only lives for this run. */
+int8_t simThreadedRun(uint8_t* prog, uint64_t progSize, sim_state_t* state, uint64_t instructLimit, sim_threaded_cache_t* cache);
+
+#endif // SIM_THREADED_H
@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <string.h>
+#include "snapshot.h"
+
+/*
+A full checkpoint scans every page of guest memory. Pages never touched read as zero without being committed, so
+the scan costs no host memory, and it needs no knowledge of how the memory was loaded. An incremental checkpoint
+only looks up the dirty bit of each page and reads the dirty ones.
+*/
+
+/*** Static function prototypes ***/
+static bool writeCheckpoint(const char* fileName, bool incremental, const sim_state_t* state, guest_mem_t* mem);
+static bool isStored(const guest_mem_t* mem, uint64_t adr, bool incremental);
+static bool isZeroPage(const uint8_t* page);
+
+/* Writes the state and every non-zero page of mem to fileName as its first checkpoint. A tracked mem is cleaned, so
+   checkpoints appended later hold the pages written from here on. Returns false on failure. */
+bool snapshotSave(const char* fileName, const sim_state_t* state, guest_mem_t* mem)
+{
+    return writeCheckpoint(fileName, false, state, mem);
+}
+
+/* Appends a checkpoint of the state and the pages of mem written since the previous checkpoint to fileName. mem must
+   be tracked since then, and is cleaned. Returns false on failure. */
+bool snapshotAppend(const char* fileName, const sim_state_t* state, guest_mem_t* mem)
+{
+    if (mem->dirty == NULL)
+    {
+        fprintf(stderr, "Snapshot error: Incremental checkpoint of memory without dirty page tracking\n");
+        return false;
+    }
+    return writeCheckpoint(fileName, true, state, mem);
+}
+
+/* Creates mem with the size of the snapshot in fileName and replays its checkpoints, restoring the state of the last.
+   Pages not in any checkpoint are zero. Returns false on failure, leaving mem destroyed. */
+bool snapshotRestore(const char* fileName, sim_state_t* state, guest_mem_t* mem)
+{
+    snapshot_file_header_t header;
+    snapshot_run_t run;
+    size_t n;
+    bool retVal = true;
+    FILE* file;
+
+    if ( (file = fopen(fileName, "rb")) == NULL )
+    {
+        perror("Snapshot error: Failed opening snapshot file");
+        return false;
+    }
+    if ( fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+         header.version != SNAPSHOT_VERSION || header.regCount != SIM_REG_COUNT )
+    {
+        fprintf(stderr, "Snapshot error: '%s' is not a snapshot of this version\n", fileName);
+        fclose(file);
+        return false;
+    }
+    if (!guestMemCreate(mem, header.memSize))
+    {
+        fclose(file);
+        return false;
+    }
+
+    do
+    {
+        memcpy(state->regFile, header.regFile, sizeof(header.regFile));
+        state->pc            = header.pc;
+        state->instructCount = header.instructCount;
+        run.pageCount        = 1;
+        while (retVal && run.pageCount != 0)
+        {
+            retVal = fread(&run, sizeof(run), 1, file) == 1 &&
+                     ((uint64_t) run.firstPage + run.pageCount) * SNAPSHOT_PAGE_BYTES <= mem->size &&
+                     fread(mem->base + (uint64_t) run.firstPage * SNAPSHOT_PAGE_BYTES, SNAPSHOT_PAGE_BYTES, run.pageCount, file) == run.pageCount;
+        }
+    } while ( retVal && (n = fread(&header, 1, sizeof(header), file)) != 0 &&
+              (retVal = n == sizeof(header) && memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 &&
+                        header.version == SNAPSHOT_VERSION && header.memSize == mem->size) );
+    retVal = retVal && !ferror(file);
+    fclose(file);
+
+    if (!retVal)
+    {
+        fprintf(stderr, "Snapshot error: Snapshot file '%s' truncated or corrupt\n", fileName);
+        guestMemDestroy(mem);
+        return false;
+    }
+    state->regFile[SIM_REG_DISCARD] = 0;
+
+    return true;
+}
+
+/* Writes a checkpoint holding the pages of mem selected by isStored, in runs, and cleans a tracked mem if written */
+bool writeCheckpoint(const char* fileName, bool incremental, const sim_state_t* state, guest_mem_t* mem)
+{
+    snapshot_file_header_t header = { .magic = SNAPSHOT_MAGIC, .version = SNAPSHOT_VERSION, .regCount = SIM_REG_COUNT };
+    snapshot_run_t run;
+    uint32_t pageCount = (uint32_t) ((mem->size + SNAPSHOT_PAGE_BYTES - 1) / SNAPSHOT_PAGE_BYTES);
+    uint32_t page = 0;
+    bool retVal = true;
+    FILE* file;
+
+    if ( (file = fopen(fileName, incremental ? "ab" : "wb")) == NULL )
+    {
+        perror("Snapshot error: Failed opening snapshot file");
+        return false;
+    }
+
+    header.memSize       = mem->size;
+    header.instructCount = state->instructCount;
+    header.pc            = state->pc;
+    memcpy(header.regFile, state->regFile, sizeof(header.regFile));
+    retVal = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    while (retVal && page < pageCount)
+    {
+        for ( ; page < pageCount && !isStored(mem, (uint64_t) page * SNAPSHOT_PAGE_BYTES, incremental); page++ );
+        run.firstPage = page;
+        for ( ; page < pageCount && isStored(mem, (uint64_t) page * SNAPSHOT_PAGE_BYTES, incremental); page++ );
+        run.pageCount = page - run.firstPage;
+        if (run.pageCount != 0)
+        {
+            retVal = fwrite(&run, sizeof(run), 1, file) == 1 &&
+                     fwrite(mem->base + (uint64_t) run.firstPage * SNAPSHOT_PAGE_BYTES, SNAPSHOT_PAGE_BYTES, run.pageCount, file) == run.pageCount;
+        }
+    }
+    run = (snapshot_run_t) { .firstPage = 0, .pageCount = 0 };
+    retVal = retVal && fwrite(&run, sizeof(run), 1, file) == 1;
+    retVal = (fclose(file) == 0) && retVal;
+    if (!retVal)
+    {
+        perror("Snapshot error: Snapshot file not written to end");
+    }
+    else
+    {
+        guestMemClean(mem);
+    }
+
+    return retVal;
+}
+
+/* Full checkpoints store the non-zero pages, incremental ones the dirty pages */
+bool isStored(const guest_mem_t* mem, uint64_t adr, bool incremental)
+{
+    return incremental ? guestMemIsDirty(mem, adr) : !isZeroPage(mem->base + adr);
+}
+
+bool isZeroPage(const uint8_t* page)
+{
+    uint64_t word;
+    uint64_t bits = 0;
+
+    for (uint32_t i = 0; i < SNAPSHOT_PAGE_BYTES; i += sizeof(word))
+    {
+        memcpy(&word, page + i, sizeof(word));
+        bits |= word;
+    }
+    return bits == 0;
+}
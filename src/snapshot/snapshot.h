@@ -0,0 +1,46 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include <stdint.h>
+#include <stdbool.h>
+#include "simState.h"
+#include "guestMem.h"
+
+/*
+Snapshot of the full machine state: registers, PC, instruction count and guest memory. Memory is stored sparsely
+in pages of SNAPSHOT_PAGE_BYTES, where pages holding only zeros are skipped and runs of consecutive stored pages share
+one header, so a snapshot is about as large as the memory a program actually uses.
+
+A snapshot file holds one or more checkpoints. Each is a snapshot_file_header_t followed by runs, each a
+snapshot_run_t and the contents of its pages, ended by a run of zero pages. The first checkpoint holds the full
+memory. Checkpoints appended to it by snapshotAppend are incremental: they hold the pages written since the previous
+checkpoint, zero or not, as recorded by the guest memory's dirty page tracking, and pages they do not hold are
+unchanged. Restoring a file replays its checkpoints and resumes the last. All fields are in host byte order.
+*/
+
+#define SNAPSHOT_MAGIC          "RVSN"
+#define SNAPSHOT_VERSION        (1)
+#define SNAPSHOT_PAGE_BYTES     (4096)  // Independent of the host page size, so snapshots move between hosts
+
+typedef struct snapshot_file_header_t
+{
+    char     magic[4];      // SNAPSHOT_MAGIC without terminator
+    uint16_t version;       // SNAPSHOT_VERSION
+    uint16_t regCount;      // SIM_REG_COUNT
+    uint64_t memSize;       // Guest memory size in bytes
+    uint64_t instructCount;
+    uint32_t pc;
+    int32_t  regFile[SIM_REG_COUNT];
+} snapshot_file_header_t;
+
+/* Consecutive stored pages */
+typedef struct snapshot_run_t
+{
+    uint32_t firstPage;     // Guest address / SNAPSHOT_PAGE_BYTES
+    uint32_t pageCount;     // 0 ends the snapshot
+} snapshot_run_t;
+
+bool snapshotSave   (const char* fileName, const sim_state_t* state, guest_mem_t* mem);
+bool snapshotAppend (const char* fileName, const sim_state_t* state, guest_mem_t* mem);
+bool snapshotRestore(const char* fileName, sim_state_t* state, guest_mem_t* mem);
+
+#endif // SNAPSHOT_H
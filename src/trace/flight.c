@@ -0,0 +1,211 @@
+#include <stdbool.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "flight.h"
+#include "rv32i.h"
+
+/*
+The recorder of the running simulation is found by the signal handler through a thread local pointer, as
+synchronous signals such as SIGSEGV are delivered to the faulting thread. Dumps only use async-signal-safe calls,
+so lines are formatted by hand and written with write().
+
+Signal handlers installed before the recorder's, such as the guest memory fault handler, get the signal first, as
+they may resolve it and not return. Signals that were ignored stay ignored.
+*/
+
+#define LINE_MAX_LENGTH     (128)
+
+static const int flightSignals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT, SIGINT, SIGTERM };
+static struct sigaction previousActions[sizeof(flightSignals)/sizeof(flightSignals[0])];
+static _Thread_local flight_recorder_t* armedRecorder = NULL;
+static pthread_once_t handlersOnce = PTHREAD_ONCE_INIT;
+
+/*** Static function prototypes ***/
+static void   installHandlers(void);
+static void   signalHandler(int sig, siginfo_t* info, void* context);
+static bool   writesRd(const rv32i_decoded_t* decoded);
+static size_t appendStr(char* line, size_t pos, const char* str);
+static size_t appendHex(char* line, size_t pos, uint32_t value);
+static size_t appendDec(char* line, size_t pos, uint64_t value);
+
+/* Makes recorder the one dumped if this thread gets an abnormal signal */
+void flightArm(flight_recorder_t* recorder)
+{
+    pthread_once(&handlersOnce, installHandlers);
+    armedRecorder = recorder;
+}
+
+void flightDisarm(void)
+{
+    armedRecorder = NULL;
+}
+
+/* Returns the record of the last instruction executed, or NULL when nothing was recorded. The newest record is the
+   one not followed by its successor. */
+const flight_record_t* flightNewest(const flight_recorder_t* recorder)
+{
+    const flight_record_t* newest = NULL;
+    const flight_record_t* record;
+    const flight_record_t* next;
+
+    for (uint32_t i = 0; i < FLIGHT_RECORDER_SIZE; i++)
+    {
+        record = &recorder->records[i];
+        next   = &recorder->records[(i + 1) & (FLIGHT_RECORDER_SIZE - 1)];
+        if (record->seq != 0 && next->seq != record->seq + 1)
+        {
+            newest = record;
+        }
+    }
+    return newest;
+}
+
+/* Writes the recorded instructions to fd, oldest first */
+void flightDump(const flight_recorder_t* recorder, int fd)
+{
+    char line[LINE_MAX_LENGTH];
+    size_t pos;
+    uint32_t newest = 0;
+    uint32_t nRecords = 0;
+    rv32i_decoded_t decoded;
+    const flight_record_t* record = flightNewest(recorder);
+
+    if (record != NULL)
+    {
+        newest   = (uint32_t) (record - recorder->records);
+        nRecords = (record->seq < FLIGHT_RECORDER_SIZE) ? (uint32_t) record->seq : FLIGHT_RECORDER_SIZE;
+    }
+
+    pos = appendStr(line, 0, "Flight recorder: last ");
+    pos = appendDec(line, pos, nRecords);
+    pos = appendStr(line, pos, recorder->blocks ? " blocks entered\n" : " instructions\n");
+    (void) !write(fd, line, pos);
+
+    for (uint32_t i = newest + FLIGHT_RECORDER_SIZE - nRecords + 1; i <= newest + FLIGHT_RECORDER_SIZE; i++)
+    {
+        record   = &recorder->records[i & (FLIGHT_RECORDER_SIZE - 1)];
+        decoded = rv32iDecode(record->instruct);
+        pos = appendStr(line, 0, "  PC = 0x");
+        pos = appendHex(line, pos, record->pc);
+        pos = appendStr(line, pos, "  0x");
+        pos = appendHex(line, pos, record->instruct);
+        pos = appendStr(line, pos, "  ");
+        pos = appendStr(line, pos, rv32iInstructName(decoded.type));
+        if (recorder->interrupted && i == newest + FLIGHT_RECORDER_SIZE)
+        {
+            pos = appendStr(line, pos, "  not completed");
+        }
+        else if (!recorder->blocks && writesRd(&decoded))
+        {
+            pos = appendStr(line, pos, "  x");
+            pos = appendDec(line, pos, decoded.rd);
+            pos = appendStr(line, pos, " = 0x");
+            pos = appendHex(line, pos, (uint32_t) record->rdValue);
+        }
+        pos = appendStr(line, pos, "\n");
+        (void) !write(fd, line, pos);
+    }
+}
+
+void installHandlers(void)
+{
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = signalHandler;
+    action.sa_flags     = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < sizeof(flightSignals)/sizeof(flightSignals[0]); i++)
+    {
+        sigaction(flightSignals[i], NULL, &previousActions[i]);
+        if ( (previousActions[i].sa_flags & SA_SIGINFO) || previousActions[i].sa_handler != SIG_IGN )
+        {
+            sigaction(flightSignals[i], &action, NULL);
+        }
+    }
+}
+
+/* Dumps the recorder unless a previously installed handler resolves the signal, and then ends the process with
+   the default action of the signal */
+void signalHandler(int sig, siginfo_t* info, void* context)
+{
+    static const char message[] = "RiVIS error: Terminated by signal, dumping flight recorder\n";
+    const struct sigaction* previous = NULL;
+    sigset_t pending;
+    bool chained = false;
+
+    for (size_t i = 0; i < sizeof(flightSignals)/sizeof(flightSignals[0]); i++)
+    {
+        previous = (flightSignals[i] == sig) ? &previousActions[i] : previous;
+    }
+    if ( (previous->sa_flags & SA_SIGINFO) && previous->sa_sigaction != NULL )
+    {
+        previous->sa_sigaction(sig, info, context);
+        chained = true;
+    }
+    else if (previous->sa_handler != SIG_DFL && previous->sa_handler != SIG_IGN)
+    {
+        previous->sa_handler(sig);
+        chained = true;
+    }
+    // A handler that gives up raises the signal again, which stays pending while this one runs. Returning without
+    // doing so resolved it, e.g. the guest memory handler making a tracked page writable.
+    if (chained && sigpending(&pending) == 0 && !sigismember(&pending, sig))
+    {
+        return;
+    }
+
+    if (armedRecorder != NULL)
+    {
+        (void) !write(STDERR_FILENO, message, sizeof(message) - 1);
+        flightDump(armedRecorder, STDERR_FILENO);
+    }
+    signal(sig, SIG_DFL);
+    raise(sig); // Delivered with the default action once the handler returns
+}
+
+/* rd is written by all formats but S and B, unless it is x0 */
+bool writesRd(const rv32i_decoded_t* decoded)
+{
+    return decoded->format != RV32I_OPCODE_TYPE_UNKNOWN && decoded->format != RV32I_OPCODE_TYPE_S &&
+           decoded->format != RV32I_OPCODE_TYPE_B && decoded->rd != 0;
+}
+
+size_t appendStr(char* line, size_t pos, const char* str)
+{
+    while (*str != '\0' && pos < LINE_MAX_LENGTH)
+    {
+        line[pos++] = *str++;
+    }
+    return pos;
+}
+
+size_t appendHex(char* line, size_t pos, uint32_t value)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    for (int shift = 28; shift >= 0 && pos < LINE_MAX_LENGTH; shift -= 4)
+    {
+        line[pos++] = digits[(value >> shift) & 0xf];
+    }
+    return pos;
+}
+
+size_t appendDec(char* line, size_t pos, uint64_t value)
+{
+    char reversed[20];
+    int n = 0;
+
+    do
+    {
+        reversed[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+    while (n > 0 && pos < LINE_MAX_LENGTH)
+    {
+        line[pos++] = reversed[--n];
+    }
+    return pos;
+}
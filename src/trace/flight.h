@@ -0,0 +1,52 @@
+#ifndef FLIGHT_H
+#define FLIGHT_H
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+Flight recorder keeping the last FLIGHT_RECORDER_SIZE executed instructions in a fixed ring. It is cheap enough to
+stay on in every run, and is dumped for post-mortem context when a run fails or the process gets an abnormal signal.
+
+Engines that do not dispatch every instruction, the threaded and block based ones, record the blocks they enter
+instead, each by its first instruction, with blocks set. Their records carry no rd value.
+*/
+
+#define FLIGHT_RECORDER_SIZE    (64)    // Power of two
+
+/* Executed instruction. The instruction word is the one that executed, so a dump stays right after the code was
+   overwritten, and its rd is decoded from it when dumped. The sequence number places the record in the ring, so the
+   recorder keeps no write position that every instruction would have to load and store. Records are made before the
+   instruction executes, so the newest one tells which instruction was executing when a run is interrupted. */
+typedef struct flight_record_t
+{
+    uint64_t seq;       // Instruction number counted from 1, 0 for an unused record
+    uint32_t pc;
+    uint32_t instruct;
+    int32_t  rdValue;   // Value of rd after execution
+} flight_record_t;
+
+typedef struct flight_recorder_t
+{
+    flight_record_t records[FLIGHT_RECORDER_SIZE];
+    bool            interrupted;    // The newest instruction did not complete, e.g. as it faulted
+    bool            blocks;         // Records are blocks entered, seq counting them rather than instructions
+} flight_recorder_t;
+
+void flightArm   (flight_recorder_t* recorder);
+void flightDisarm(void);
+void flightDump  (const flight_recorder_t* recorder, int fd);
+const flight_record_t* flightNewest(const flight_recorder_t* recorder);
+
+/* Records instruction number seq, the word instruct at pc, before it executes, overwriting the oldest record. The
+   rdValue of the returned record is to be set once the instruction has executed. */
+static inline flight_record_t* flightRecord(flight_recorder_t* recorder, uint64_t seq, uint32_t pc, uint32_t instruct)
+{
+    flight_record_t* record = &recorder->records[seq & (FLIGHT_RECORDER_SIZE - 1)];
+
+    record->seq      = seq;
+    record->pc       = pc;
+    record->instruct = instruct;
+    return record;
+}
+
+#endif // FLIGHT_H
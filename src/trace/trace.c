@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "trace.h"
+
+/* Writer thread state. All fields are protected by lock. */
+struct trace_writer_t
+{
+    FILE*           file;
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  work;       // Signalled when records are published or the trace is closing
+    pthread_cond_t  room;       // Signalled when records have been written out
+    uint64_t        published;  // Records ready for writing
+    uint64_t        written;    // Records written out, their slots may be reused
+    bool            closing;
+    bool            failed;     // A write failed, remaining records are dropped
+};
+
+/*** Static function prototypes ***/
+static void* writerThread(void* arg);
+static bool  writeRecords(FILE* file, const trace_record_t* ring, uint64_t mask, uint64_t from, uint64_t to);
+
+trace_t* traceOpen(const char* fileName, uint32_t capacity)
+{
+    trace_t* trace = NULL;
+    trace_writer_t* writer = NULL;
+    trace_file_header_t header = {
+        .version    = TRACE_VERSION,
+        .recordSize = sizeof(trace_record_t),
+    };
+
+    if (capacity < 4 || (capacity & (capacity - 1)) != 0)
+    {
+        fprintf(stderr, "Trace error: Capacity %u is not a power of two of at least 4\n", capacity);
+        return NULL;
+    }
+    if ( (trace = calloc(1, sizeof(trace_t))) == NULL ||
+         (writer = calloc(1, sizeof(trace_writer_t))) == NULL ||
+         (trace->ring = malloc(capacity * sizeof(trace_record_t))) == NULL )
+    {
+        fprintf(stderr, "Trace error: Failed to allocate memory for trace buffer\n");
+        goto fail;
+    }
+    if ( (writer->file = fopen(fileName, "wb")) == NULL )
+    {
+        perror("Trace error: Failed opening trace file");
+        goto fail;
+    }
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    if (fwrite(&header, sizeof(header), 1, writer->file) != 1)
+    {
+        fprintf(stderr, "Trace error: Failed to write trace file header\n");
+        goto fail;
+    }
+
+    trace->mask   = capacity - 1;
+    trace->limit  = capacity / 4;   // Hand records to the writer a quarter of the ring at a time
+    trace->writer = writer;
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->work, NULL);
+    pthread_cond_init(&writer->room, NULL);
+    if (pthread_create(&writer->thread, NULL, writerThread, trace) != 0)
+    {
+        fprintf(stderr, "Trace error: Failed to start writer thread\n");
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->work);
+        pthread_cond_destroy(&writer->room);
+        goto fail;
+    }
+    return trace;
+
+fail:
+    if (writer != NULL && writer->file != NULL)
+    {
+        fclose(writer->file);
+    }
+    if (trace != NULL)
+    {
+        free(trace->ring);
+    }
+    free(writer);
+    free(trace);
+    return NULL;
+}
+
+/* Writes out all records and closes the trace. Returns false if any record could not be written. */
+bool traceClose(trace_t* trace)
+{
+    trace_writer_t* writer;
+    bool retVal;
+
+    if (trace == NULL)
+    {
+        return true;
+    }
+    writer = trace->writer;
+
+    pthread_mutex_lock(&writer->lock);
+    writer->published = trace->head;
+    writer->closing = true;
+    pthread_cond_signal(&writer->work);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+
+    retVal = !writer->failed;
+    if (fclose(writer->file) != 0)
+    {
+        retVal = false;
+    }
+    if (!retVal)
+    {
+        fprintf(stderr, "Trace error: Failed to write trace file\n");
+    }
+
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->work);
+    pthread_cond_destroy(&writer->room);
+    free(trace->ring);
+    free(writer);
+    free(trace);
+    return retVal;
+}
+
+/* Slow path of traceRecord. Publishes all handed out records, waits for a free slot if the ring is full, and sets
+   the next limit at the end of the next batch or of the free space, whichever comes first. */
+void traceCommit(trace_t* trace)
+{
+    trace_writer_t* writer = trace->writer;
+    uint64_t capacity = trace->mask + 1;
+
+    pthread_mutex_lock(&writer->lock);
+    writer->published = trace->head;
+    pthread_cond_signal(&writer->work);
+    while (trace->head - writer->written == capacity)
+    {
+        pthread_cond_wait(&writer->room, &writer->lock);
+    }
+    trace->limit = writer->written + capacity;
+    pthread_mutex_unlock(&writer->lock);
+
+    if (trace->limit > trace->head + capacity / 4)
+    {
+        trace->limit = trace->head + capacity / 4;
+    }
+}
+
+/* Writes published records until the trace is closed and drained. The slots being written are never handed out
+   to the producer, so the file is written without holding the lock. */
+void* writerThread(void* arg)
+{
+    trace_t* trace = arg;
+    trace_writer_t* writer = trace->writer;
+    uint64_t from, to;
+    bool ok;
+
+    pthread_mutex_lock(&writer->lock);
+    while (true)
+    {
+        while (writer->published == writer->written && !writer->closing)
+        {
+            pthread_cond_wait(&writer->work, &writer->lock);
+        }
+        if (writer->published == writer->written)
+        {
+            break;  // Closing and all records written
+        }
+        from = writer->written;
+        to   = writer->published;
+        pthread_mutex_unlock(&writer->lock);
+
+        ok = writer->failed || writeRecords(writer->file, trace->ring, trace->mask, from, to);
+
+        pthread_mutex_lock(&writer->lock);
+        writer->failed |= !ok;
+        writer->written = to;
+        pthread_cond_signal(&writer->room);
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    return NULL;
+}
+
+/* Writes records from up to but excluding to, in at most two parts when the range wraps around the ring */
+bool writeRecords(FILE* file, const trace_record_t* ring, uint64_t mask, uint64_t from, uint64_t to)
+{
+    uint64_t start = from & mask;
+    uint64_t count = to - from;
+    uint64_t first = (start + count <= mask + 1) ? count : mask + 1 - start;
+
+    if (fwrite(ring + start, sizeof(trace_record_t), first, file) != first)
+    {
+        return false;
+    }
+    return fwrite(ring, sizeof(trace_record_t), count - first, file) == count - first;
+}
@@ -0,0 +1,69 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+Binary execution trace. The simulator fills fixed size records in an in-memory ring buffer, and a background
+writer thread appends them to the trace file. Records are handed to the writer in batches, so the simulator only
+synchronises with it once per batch, and waits only when the ring is full.
+
+A trace file is a trace_file_header_t followed by trace_record_t records, both in host byte order.
+*/
+
+#define TRACE_MAGIC             "RVTR"
+#define TRACE_VERSION           (1)
+#define TRACE_DEFAULT_CAPACITY  (1 << 16)   // Records in the ring buffer
+
+/* trace_record_t flags */
+#define TRACE_FLAG_WRITE        (1 << 0)    // rd was written with rdValue
+#define TRACE_FLAG_LOAD         (1 << 1)    // memAdr was read
+#define TRACE_FLAG_STORE        (1 << 2)    // memAdr was written
+
+typedef struct trace_file_header_t
+{
+    char     magic[4];      // TRACE_MAGIC without terminator
+    uint16_t version;       // TRACE_VERSION
+    uint16_t recordSize;    // sizeof(trace_record_t)
+} trace_file_header_t;
+
+/* One executed instruction */
+typedef struct trace_record_t
+{
+    uint32_t pc;
+    uint32_t instruct;      // Instruction word as executed
+    int32_t  rdValue;       // New value of rd, valid with TRACE_FLAG_WRITE
+    uint32_t memAdr;        // Accessed address, valid with TRACE_FLAG_LOAD or TRACE_FLAG_STORE
+    uint8_t  rd;
+    uint8_t  flags;         // TRACE_FLAG_*
+    uint8_t  reserved[2];
+} trace_record_t;
+
+typedef struct trace_writer_t trace_writer_t;
+
+/* Producer side of the ring, used by the inline traceRecord. The writer state is private to trace.c. */
+typedef struct trace_t
+{
+    trace_record_t* ring;
+    uint64_t        mask;       // Ring capacity - 1
+    uint64_t        head;       // Number of records handed out
+    uint64_t        limit;      // traceRecord calls traceCommit when head reaches limit
+    trace_writer_t* writer;
+} trace_t;
+
+trace_t* traceOpen  (const char* fileName, uint32_t capacity);
+bool     traceClose (trace_t* trace);
+void     traceCommit(trace_t* trace);
+
+/* Returns the record to fill for the next instruction. It must be filled before the next call, which may hand it
+   to the writer. */
+static inline trace_record_t* traceRecord(trace_t* trace)
+{
+    if (trace->head == trace->limit)
+    {
+        traceCommit(trace);
+    }
+    return &trace->ring[trace->head++ & trace->mask];
+}
+
+#endif // TRACE_H
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "trace.h"
+#include "rv32i.h"
+
+/*
+Offline pretty-printer for binary execution traces written by RiVIS -t. Prints one line per executed instruction
+with its PC, instruction word, mnemonic, register write and memory access.
+*/
+
+#define RECORDS_PER_READ    (4096)
+
+/*** Static function prototypes ***/
+static void printRecord(uint64_t index, const trace_record_t* record);
+
+int main(int argc, char *argv[])
+{
+    FILE* file = NULL;
+    trace_file_header_t header;
+    static trace_record_t records[RECORDS_PER_READ];
+    uint64_t index = 0;
+    size_t nRecords;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <tracefile>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if ( (file = fopen(argv[1], "rb")) == NULL )
+    {
+        perror("RiVIS-trace error: Failed opening trace file");
+        exit(EXIT_FAILURE);
+    }
+    if ( fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 )
+    {
+        fprintf(stderr, "RiVIS-trace error: %s is not a trace file\n", argv[1]);
+        fclose(file);
+        exit(EXIT_FAILURE);
+    }
+    if ( header.version != TRACE_VERSION || header.recordSize != sizeof(trace_record_t) )
+    {
+        fprintf(stderr, "RiVIS-trace error: Unsupported trace version %u with record size %u\n", header.version, header.recordSize);
+        fclose(file);
+        exit(EXIT_FAILURE);
+    }
+
+    while ( (nRecords = fread(records, sizeof(trace_record_t), RECORDS_PER_READ, file)) > 0 )
+    {
+        for (size_t i = 0; i < nRecords; i++)
+        {
+            printRecord(index++, &records[i]);
+        }
+    }
+    fclose(file);
+
+    exit(EXIT_SUCCESS);
+}
+
+void printRecord(uint64_t index, const trace_record_t* record)
+{
+    printf("%10" PRIu64 "  PC = 0x%08x  0x%08x  %-6s", index, record->pc, record->instruct,
+           rv32iInstructName(rv32iDecodeInstructType(record->instruct)));
+    if (record->flags & TRACE_FLAG_WRITE)
+    {
+        printf("  x%-2u = 0x%08x (%d)", record->rd, (uint32_t) record->rdValue, record->rdValue);
+    }
+    if (record->flags & TRACE_FLAG_LOAD)
+    {
+        printf("  load [0x%08x]", record->memAdr);
+    }
+    if (record->flags & TRACE_FLAG_STORE)
+    {
+        printf("  store [0x%08x]", record->memAdr);
+    }
+    printf("\n");
+}
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+extern "C" {
+    #include <batch.h>
+}
+
+/*
+System test driver. Runs every program <name>.bin in the task folders of the system test directory on the simulator
+library, and compares the register file it ends with against <name>.res with memcmp, printing the differing registers
+on a mismatch. All programs of a run form one batch, so they run in parallel within this process, and nothing is
+written to the test folders. The folders default to every task* folder of the directory.
+
+Usage: systemTest [-e <engine>] [-j <threads>] <directory> [<folder>...]
+*/
+
+#define USAGE_FMT   "Usage: %s [-e <engine>] [-j <threads>] <directory> [<folder>...]\n"
+
+namespace fs = std::filesystem;
+
+/*** Static function prototypes ***/
+static bool findTaskFolders(const fs::path& directory, std::vector<std::string>& folders);
+static bool findPrograms(const fs::path& folder, std::vector<std::string>& programs);
+
+int main(int argc, char* argv[])
+{
+    batch_options_t options = { .engine = SIM_ENGINE_SOFT, .memSize = GUEST_MEM_DEFAULT_BYTES, .format = FILEUTILS_FORMAT_AUTO };
+    const char* directory = NULL;
+    std::vector<std::string> folders;
+    std::vector<std::string> programs;      // Paths without the extension
+    std::vector<std::string> inputs;
+    std::vector<std::string> expects;
+    std::vector<batch_job_t> jobs;
+    batch_t batch = {};
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+        {
+            options.engine = simEngineFromName(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            options.threads = (uint32_t) strtoul(argv[++i], NULL, 0);
+        }
+        else if (directory == NULL)
+        {
+            directory = argv[i];
+        }
+        else
+        {
+            folders.push_back(argv[i]);
+        }
+    }
+    if (directory == NULL || options.engine == SIM_ENGINE_UNKNOWN)
+    {
+        fprintf(stderr, USAGE_FMT, argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (folders.empty() && !findTaskFolders(directory, folders))
+    {
+        return EXIT_FAILURE;
+    }
+    for (const std::string& folder : folders)
+    {
+        if (!findPrograms((fs::path(directory) / folder).lexically_normal(), programs))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    if (programs.empty())
+    {
+        fprintf(stderr, "systemTest error: No programs in the task folders of '%s'\n", directory);
+        return EXIT_FAILURE;
+    }
+
+    // The strings outlive the batch, whose jobs point into them
+    for (const std::string& program : programs)
+    {
+        inputs.push_back(program + ".bin");
+        expects.push_back(program + ".res");
+    }
+    jobs.resize(programs.size());
+    for (size_t i = 0; i < programs.size(); i++)
+    {
+        jobs[i].inFileName     = inputs[i].c_str();
+        jobs[i].expectFileName = expects[i].c_str();
+    }
+    batch.jobs  = jobs.data();
+    batch.count = (uint32_t) jobs.size();
+
+    if (!batchRun(&batch, &options))
+    {
+        return EXIT_FAILURE;
+    }
+    printf("Engine: %s\n", simEngineName(options.engine));
+    return (batchReport(stdout, &batch) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Appends the task* folders of directory to folders, sorted by name. Returns false on failure. */
+bool findTaskFolders(const fs::path& directory, std::vector<std::string>& folders)
+{
+    std::error_code error;
+    std::string name;
+
+    for (const fs::directory_entry& entry : fs::directory_iterator(directory, error))
+    {
+        name = entry.path().filename().string();
+        if (entry.is_directory(error) && name.compare(0, 4, "task") == 0)
+        {
+            folders.push_back(name);
+        }
+    }
+    if (error)
+    {
+        fprintf(stderr, "systemTest error: Failed listing '%s': %s\n", directory.c_str(), error.message().c_str());
+        return false;
+    }
+    std::sort(folders.begin(), folders.end());
+    return true;
+}
+
+/* Appends the paths of the .bin files in folder, without the extension, to programs, sorted by name. Returns false
+   on failure. */
+bool findPrograms(const fs::path& folder, std::vector<std::string>& programs)
+{
+    std::error_code error;
+    std::vector<std::string> found;
+
+    for (const fs::directory_entry& entry : fs::directory_iterator(folder, error))
+    {
+        if (entry.path().extension() == ".bin")
+        {
+            found.push_back(fs::path(entry.path()).replace_extension().string());
+        }
+    }
+    if (error)
+    {
+        fprintf(stderr, "systemTest error: Failed listing '%s': %s\n", folder.c_str(), error.message().c_str());
+        return false;
+    }
+    std::sort(found.begin(), found.end());
+    programs.insert(programs.end(), found.begin(), found.end());
+    return true;
+}
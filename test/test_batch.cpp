@@ -0,0 +1,466 @@
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+extern "C" {
+    #include <batch.h>
+}
+
+#define BATCH_TEST_MANIFEST     "test_batch.txt"
+#define BATCH_TEST_PROGRAM      "test_batch.bin"
+#define BATCH_TEST_PASS         "test_batch_pass.res"
+#define BATCH_TEST_FAIL         "test_batch_fail.res"
+#define BATCH_TEST_OUTPUT       "test_batch_out.res"
+#define BATCH_TEST_FAULT        "test_batch_fault.bin"
+#define BATCH_TEST_FAULT_LOOP   "test_batch_fault_loop.bin"
+#define BATCH_TEST_FAULT_OUTPUT "test_batch_fault_out.res"
+#define BATCH_TEST_TRACE        "test_batch.trace"
+
+static const batch_options_t testOptions = { .engine = SIM_ENGINE_SOFT, .memSize = 1 << 20, .format = FILEUTILS_FORMAT_AUTO };
+
+static void writeFile(const char* fileName, const void* data, size_t size)
+{
+    FILE* file = fopen(fileName, "wb");
+
+    fwrite(data, 1, size, file);
+    fclose(file);
+}
+
+// addi x5,x0,42; addi a7,x0,10; ecall, and the register files it does and does not end with
+static void writeProgram(void)
+{
+    const uint32_t program[] = { 0x02A00293, 0x00A00893, 0x00000073 };
+    int32_t regFile[SIM_REG_COUNT] = {};
+
+    writeFile(BATCH_TEST_PROGRAM, program, sizeof(program));
+    regFile[5]  = 42;
+    regFile[17] = 10;
+    writeFile(BATCH_TEST_PASS, regFile, BATCH_REG_FILE_BYTES);
+    regFile[5]  = 43;
+    writeFile(BATCH_TEST_FAIL, regFile, BATCH_REG_FILE_BYTES);
+}
+
+// Every test runs in its own temporary directory, as CTest runs the tests of this file concurrently
+class batch : public ::testing::Test
+{
+protected:
+    char directory[32] = "/tmp/test_batchXXXXXX";
+    char previous[4096];
+
+    void SetUp() override
+    {
+        ASSERT_NE(getcwd(previous, sizeof(previous)), nullptr);
+        ASSERT_NE(mkdtemp(directory), nullptr);
+        ASSERT_EQ(chdir(directory), 0);
+    }
+
+    void TearDown() override
+    {
+        unlink(BATCH_TEST_MANIFEST);
+        unlink(BATCH_TEST_PROGRAM);
+        unlink(BATCH_TEST_PASS);
+        unlink(BATCH_TEST_FAIL);
+        unlink(BATCH_TEST_OUTPUT);
+        unlink(BATCH_TEST_FAULT);
+        unlink(BATCH_TEST_FAULT_LOOP);
+        unlink(BATCH_TEST_FAULT_OUTPUT);
+        unlink(BATCH_TEST_TRACE);
+        EXPECT_EQ(chdir(previous), 0);
+        rmdir(directory);
+    }
+};
+
+// Comments and blank lines are skipped, and - or a missing field leaves it unset
+TEST_F(batch, ReadManifest)
+{
+    const char manifest[] = "# Jobs\n\na.bin\nb.bin - b.res  # Compare only\n\tc.bin c.out c.res\r\n";
+    batch_t batch;
+
+    writeFile(BATCH_TEST_MANIFEST, manifest, sizeof(manifest) - 1);
+    ASSERT_TRUE(batchReadManifest(BATCH_TEST_MANIFEST, &batch));
+    ASSERT_EQ(batch.count, 3u);
+    EXPECT_STREQ(batch.jobs[0].inFileName, "a.bin");
+    EXPECT_EQ(batch.jobs[0].outFileName, nullptr);
+    EXPECT_EQ(batch.jobs[0].expectFileName, nullptr);
+    EXPECT_STREQ(batch.jobs[1].inFileName, "b.bin");
+    EXPECT_EQ(batch.jobs[1].outFileName, nullptr);
+    EXPECT_STREQ(batch.jobs[1].expectFileName, "b.res");
+    EXPECT_STREQ(batch.jobs[2].inFileName, "c.bin");
+    EXPECT_STREQ(batch.jobs[2].outFileName, "c.out");
+    EXPECT_STREQ(batch.jobs[2].expectFileName, "c.res");
+    EXPECT_EQ(batch.jobs[2].status, BATCH_PENDING);
+
+    batchFree(&batch);
+    EXPECT_EQ(batch.jobs, nullptr);
+}
+
+TEST_F(batch, ReadManifestInvalid)
+{
+    const char* manifests[] = { "a.bin b.res c.res d.res\n", "- out.res\n", "# Nothing\n\n" };
+    batch_t batch;
+
+    for (const char* manifest : manifests)
+    {
+        writeFile(BATCH_TEST_MANIFEST, manifest, strlen(manifest));
+        EXPECT_FALSE(batchReadManifest(BATCH_TEST_MANIFEST, &batch)) << manifest;
+        EXPECT_EQ(batch.jobs, nullptr);
+        EXPECT_EQ(batch.count, 0u);
+    }
+    EXPECT_FALSE(batchReadManifest("/nonexistent/jobs.txt", &batch));
+}
+
+// Every job gets its outcome, and the report counts those not passed
+TEST_F(batch, Run)
+{
+    const char manifest[] = BATCH_TEST_PROGRAM " " BATCH_TEST_OUTPUT " " BATCH_TEST_PASS "\n"
+                            BATCH_TEST_PROGRAM " - " BATCH_TEST_FAIL "\n"
+                            BATCH_TEST_PROGRAM "\n"
+                            "/nonexistent/test.bin\n"
+                            BATCH_TEST_PROGRAM " - /nonexistent/test.res\n";
+    batch_options_t options = testOptions;
+    int32_t regFile[SIM_REG_COUNT] = {};
+    batch_t batch;
+    FILE* null = fopen("/dev/null", "w");
+
+    writeProgram();
+    writeFile(BATCH_TEST_MANIFEST, manifest, sizeof(manifest) - 1);
+    options.threads = 3;
+    ASSERT_TRUE(batchReadManifest(BATCH_TEST_MANIFEST, &batch));
+    ASSERT_TRUE(batchRun(&batch, &options));
+    EXPECT_EQ(batch.threads, 3u);
+    EXPECT_EQ(batch.jobs[0].status, BATCH_PASS);
+    EXPECT_EQ(batch.jobs[1].status, BATCH_FAIL);
+    EXPECT_EQ(batch.jobs[2].status, BATCH_PASS);
+    EXPECT_EQ(batch.jobs[3].status, BATCH_ERROR);
+    EXPECT_EQ(batch.jobs[4].status, BATCH_ERROR);
+    EXPECT_EQ(batch.jobs[0].state.instructCount, 3u);
+    EXPECT_EQ(batch.jobs[1].state.regFile[5], 42);
+    EXPECT_EQ(batch.jobs[1].expected[5], 43);
+    EXPECT_EQ(fileutilsLoadBinary(BATCH_TEST_OUTPUT, (uint8_t*) regFile, sizeof(regFile)), BATCH_REG_FILE_BYTES);
+    EXPECT_EQ(regFile[5], 42);
+    EXPECT_EQ(batchReport(null, &batch), 3u);
+
+    fclose(null);
+    batchFree(&batch);
+}
+
+// One worker running the same input over and over starts each run from its initial memory
+TEST_F(batch, RunRepeated)
+{
+    // lw x5,64(x0); addi x5,x5,1; sw x5,64(x0); addi a7,x0,10; ecall counts the runs in memory unless it is reset
+    const uint32_t program[] = { 0x04002283, 0x00128293, 0x04502023, 0x00A00893, 0x00000073 };
+    int32_t regFile[SIM_REG_COUNT] = {};
+    batch_options_t options = testOptions;
+    batch_t batch;
+    char manifest[256] = "";
+
+    writeFile(BATCH_TEST_PROGRAM, program, sizeof(program));
+    regFile[5]  = 1;
+    regFile[17] = 10;
+    writeFile(BATCH_TEST_PASS, regFile, BATCH_REG_FILE_BYTES);
+    for (int i = 0; i < 5; i++)
+    {
+        strcat(manifest, BATCH_TEST_PROGRAM " - " BATCH_TEST_PASS "\n");
+    }
+    writeFile(BATCH_TEST_MANIFEST, manifest, strlen(manifest));
+    options.threads = 1;
+    ASSERT_TRUE(batchReadManifest(BATCH_TEST_MANIFEST, &batch));
+    ASSERT_TRUE(batchRun(&batch, &options));
+    EXPECT_EQ(batch.threads, 1u);
+    for (uint32_t i = 0; i < batch.count; i++)
+    {
+        EXPECT_EQ(batch.jobs[i].status, BATCH_PASS) << i;
+    }
+
+    batchFree(&batch);
+}
+
+// Jobs suspended at the end of each slice are resumed where they stopped, on any worker, with every engine
+TEST_F(batch, RunSliced)
+{
+    // addi x5,x0,100; loop: addi x5,x5,-1; bne x5,x0,loop; addi a7,x0,10; ecall runs 203 instructions
+    const uint32_t program[] = { 0x06400293, 0xFFF28293, 0xFE029EE3, 0x00A00893, 0x00000073 };
+    const sim_engine_t engines[] = { SIM_ENGINE_SOFT, SIM_ENGINE_THREADED, SIM_ENGINE_BLOCK, SIM_ENGINE_JIT, SIM_ENGINE_TIERED };
+    int32_t regFile[SIM_REG_COUNT] = {};
+    batch_options_t options = testOptions;
+    batch_t batch;
+    char manifest[256] = "";
+    FILE* progress = tmpfile();
+    char line[256];
+    uint32_t lines = 0;
+
+    writeFile(BATCH_TEST_PROGRAM, program, sizeof(program));
+    regFile[17] = 10;
+    writeFile(BATCH_TEST_PASS, regFile, BATCH_REG_FILE_BYTES);
+    for (int i = 0; i < 4; i++)
+    {
+        strcat(manifest, BATCH_TEST_PROGRAM " - " BATCH_TEST_PASS "\n");
+    }
+    writeFile(BATCH_TEST_MANIFEST, manifest, strlen(manifest));
+    options.threads  = 2;
+    options.slice    = 10;
+    options.progress = progress;
+    ASSERT_TRUE(batchReadManifest(BATCH_TEST_MANIFEST, &batch));
+    for (sim_engine_t engine : engines)
+    {
+        options.engine = engine;
+        ASSERT_TRUE(batchRun(&batch, &options));
+        for (uint32_t i = 0; i < batch.count; i++)
+        {
+            EXPECT_EQ(batch.jobs[i].status, BATCH_PASS) << simEngineName(engine) << " job " << i;
+            EXPECT_EQ(batch.jobs[i].state.instructCount, 203u) << simEngineName(engine);
+            EXPECT_EQ(batch.jobs[i].mem.base, nullptr);
+            EXPECT_EQ(batch.jobs[i].context, nullptr);
+            if (engine == SIM_ENGINE_SOFT)
+            {
+                EXPECT_EQ(batch.jobs[i].slices, 21u);
+            }
+            else
+            {
+                EXPECT_GT(batch.jobs[i].slices, 1u) << simEngineName(engine);
+            }
+        }
+    }
+
+    // One progress line per finished job
+    rewind(progress);
+    while (fgets(line, sizeof(line), progress) != NULL)
+    {
+        EXPECT_EQ(strncmp(line, "PASS", 4), 0) << line;
+        lines++;
+    }
+    EXPECT_EQ(lines, 5 * batch.count);
+
+    fclose(progress);
+    batchFree(&batch);
+}
+
+// A run resumed with the context of the previous slice reuses its blocks rather than translating them again
+TEST_F(batch, ResumeWarm)
+{
+    const uint32_t program[] = { 0x06400293, 0xFFF28293, 0xFE029EE3, 0x00A00893, 0x00000073 };
+    const sim_engine_t engines[] = { SIM_ENGINE_BLOCK, SIM_ENGINE_JIT };
+    guest_mem_t mem;
+    sim_context_t* context;
+    sim_options_t simOptions = {};
+    sim_stats_t stats;
+    sim_state_t state;
+
+    ASSERT_TRUE(guestMemCreate(&mem, 1 << 20));
+    memcpy(mem.base, program, sizeof(program));
+    for (sim_engine_t engine : engines)
+    {
+        state = {};
+        ASSERT_NE(context = simContextCreate(engine, mem.base, mem.size), nullptr);
+        simOptions.context       = context;
+        simOptions.instructLimit = 10;
+        EXPECT_EQ(simRun(engine, mem.base, mem.size, &state, &simOptions, &stats), SIM_RUN_LIMIT) << simEngineName(engine);
+        EXPECT_GT(stats.translated + stats.compiled, 0u) << simEngineName(engine);
+        simOptions.instructLimit = state.instructCount + 10;
+        EXPECT_EQ(simRun(engine, mem.base, mem.size, &state, &simOptions, &stats), SIM_RUN_LIMIT) << simEngineName(engine);
+        EXPECT_EQ(stats.translated + stats.compiled, 0u) << simEngineName(engine);
+        simOptions.instructLimit = 0;
+        EXPECT_EQ(simRun(engine, mem.base, mem.size, &state, &simOptions, &stats), 0) << simEngineName(engine);
+        EXPECT_EQ(state.instructCount, 203u) << simEngineName(engine);
+        simContextDestroy(context);
+    }
+    guestMemDestroy(&mem);
+}
+
+// A run split into phases, as RiVIS does for snapshots, appends to one trace and adds up to the statistics of one run
+TEST_F(batch, TracePhases)
+{
+    const uint32_t program[] = { 0x06400293, 0xFFF28293, 0xFE029EE3, 0x00A00893, 0x00000073 };
+    guest_mem_t mem;
+    sim_options_t simOptions = { .stats = true };
+    sim_stats_t stats = {};
+    sim_stats_t phase;
+    sim_state_t state = {};
+    struct stat traceStat;
+
+    ASSERT_TRUE(guestMemCreate(&mem, 1 << 20));
+    memcpy(mem.base, program, sizeof(program));
+    ASSERT_NE(simOptions.trace = traceOpen(BATCH_TEST_TRACE, TRACE_DEFAULT_CAPACITY), nullptr);
+    for (uint64_t limit : { 10, 150, 0 })
+    {
+        simOptions.instructLimit = limit;
+        EXPECT_EQ(simRun(SIM_ENGINE_SOFT, mem.base, mem.size, &state, &simOptions, &phase), (limit != 0) ? SIM_RUN_LIMIT : 0);
+        simStatsAdd(&stats, &phase);
+    }
+    EXPECT_TRUE(traceClose(simOptions.trace));
+    guestMemDestroy(&mem);
+
+    EXPECT_EQ(stats.instructCount, 203u);
+    EXPECT_EQ(stats.instructMix[RV32I_ADDI], 102u);
+    EXPECT_EQ(stats.instructMix[RV32I_BNE], 100u);
+    ASSERT_EQ(stat(BATCH_TEST_TRACE, &traceStat), 0);
+    EXPECT_EQ((uint64_t) traceStat.st_size, sizeof(trace_file_header_t) + 203 * sizeof(trace_record_t));
+}
+
+// Code overwritten after it was translated runs as the new instructions, while data stores to the page of the code
+// leave the translations in place, on every engine
+TEST_F(batch, RunSelfModifying)
+{
+    // x7 counts 20 iterations of a loop whose first instruction, addi x5,x5,1, is overwritten by addi x5,x5,16 from
+    // address 64 in the last two iterations. The other iterations store to the data word at 128 instead.
+    const uint32_t program[] = {
+        0x00000293, 0x01400393, 0x04002403,     // addi x5,x0,0; addi x7,x0,20; lw x8,64(x0)
+        0x00128293, 0x0033A513, 0x40A005B3,     // loop: addi x5,x5,1; slti x10,x7,3; sub x11,x0,x10
+        0x08C5F613, 0x08064493, 0x0084A023,     // andi x12,x11,140; xori x9,x12,128; sw x8,0(x9)
+        0xFFF38393, 0xFE0392E3,                 // addi x7,x7,-1; bne x7,x0,loop
+        0x00A00893, 0x00000073, 0, 0, 0,        // addi a7,x0,10; ecall
+        0x01028293,                             // addi x5,x5,16
+    };
+    const sim_engine_t engines[] = { SIM_ENGINE_SOFT, SIM_ENGINE_THREADED, SIM_ENGINE_BLOCK, SIM_ENGINE_JIT, SIM_ENGINE_TIERED };
+    const char manifest[] = BATCH_TEST_PROGRAM "\n";
+    batch_options_t options = testOptions;
+    batch_t batch;
+
+    writeFile(BATCH_TEST_PROGRAM, program, sizeof(program));
+    writeFile(BATCH_TEST_MANIFEST, manifest, sizeof(manifest) - 1);
+    options.threads = 1;
+    ASSERT_TRUE(batchReadManifest(BATCH_TEST_MANIFEST, &batch));
+    for (sim_engine_t engine : engines)
+    {
+        options.engine = engine;
+        ASSERT_TRUE(batchRun(&batch, &options));
+        EXPECT_EQ(batch.jobs[0].status, BATCH_PASS) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[0].state.regFile[5], 19 + 16) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[0].state.regFile[9], 12) << simEngineName(engine);
+    }
+
+    batchFree(&batch);
+}
+
+// A job faulting in guest memory is an error on every engine, left at the faulting instruction, and the other jobs
+// of the batch still run
+TEST_F(batch, RunFault)
+{
+    // lui x6,0x80000; lw x7,0(x6) loads from beyond the guest memory
+    const uint32_t fault[] = { 0x80000337, 0x00032383, 0x00A00893, 0x00000073 };
+    // lui x6,0xD8; lui x8,1; loop: add x6,x6,x8; lw x7,0(x6); jal x0,loop faults in the 40th iteration, once the
+    // loop block is compiled on the engines with a JIT
+    const uint32_t faultLoop[] = { 0x000D8337, 0x00001437, 0x00830333, 0x00032383, 0xFF9FF06F };
+    const sim_engine_t engines[] = { SIM_ENGINE_SOFT, SIM_ENGINE_THREADED, SIM_ENGINE_BLOCK, SIM_ENGINE_JIT, SIM_ENGINE_TIERED };
+    const char manifest[] = BATCH_TEST_PROGRAM " - " BATCH_TEST_PASS "\n"
+                            BATCH_TEST_FAULT "\n"
+                            BATCH_TEST_PROGRAM " - " BATCH_TEST_PASS "\n"
+                            BATCH_TEST_FAULT_LOOP "\n";
+    batch_options_t options = testOptions;
+    batch_t batch;
+
+    writeProgram();
+    writeFile(BATCH_TEST_FAULT, fault, sizeof(fault));
+    writeFile(BATCH_TEST_FAULT_LOOP, faultLoop, sizeof(faultLoop));
+    writeFile(BATCH_TEST_MANIFEST, manifest, sizeof(manifest) - 1);
+    options.threads = 1;
+    ASSERT_TRUE(batchReadManifest(BATCH_TEST_MANIFEST, &batch));
+    for (sim_engine_t engine : engines)
+    {
+        options.engine = engine;
+        ASSERT_TRUE(batchRun(&batch, &options));
+        EXPECT_EQ(batch.jobs[0].status, BATCH_PASS) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[1].status, BATCH_ERROR) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[1].simResult, SIM_RUN_FAULT) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[1].state.pc, 4u) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[1].state.instructCount, 1u) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[2].status, BATCH_PASS) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[3].status, BATCH_ERROR) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[3].state.pc, 12u) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[3].state.instructCount, 2u + 39 * 3 + 1) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[3].state.regFile[6], 0x100000) << simEngineName(engine);
+    }
+
+    batchFree(&batch);
+}
+
+// A jump to a misaligned PC is an error on every engine, leaving the PC at the jump target
+TEST_F(batch, RunMisaligned)
+{
+    // addi x5,x0,6; jalr x0,0(x5)
+    const uint32_t program[] = { 0x00600293, 0x00028067 };
+    const sim_engine_t engines[] = { SIM_ENGINE_SOFT, SIM_ENGINE_THREADED, SIM_ENGINE_BLOCK, SIM_ENGINE_JIT, SIM_ENGINE_TIERED };
+    const char manifest[] = BATCH_TEST_PROGRAM "\n";
+    batch_options_t options = testOptions;
+    batch_t batch;
+
+    writeFile(BATCH_TEST_PROGRAM, program, sizeof(program));
+    writeFile(BATCH_TEST_MANIFEST, manifest, sizeof(manifest) - 1);
+    options.threads = 1;
+    ASSERT_TRUE(batchReadManifest(BATCH_TEST_MANIFEST, &batch));
+    for (sim_engine_t engine : engines)
+    {
+        options.engine = engine;
+        ASSERT_TRUE(batchRun(&batch, &options));
+        EXPECT_EQ(batch.jobs[0].status, BATCH_ERROR) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[0].state.pc, 6u) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[0].state.regFile[5], 6) << simEngineName(engine);
+    }
+
+    batchFree(&batch);
+}
+
+// A run ending in an unsupported ECALL still writes and compares its register file on every engine, while a faulted
+// run writes none
+TEST_F(batch, RunEcallUnsupported)
+{
+    // addi x5,x0,42; addi a7,x0,5; ecall
+    const uint32_t program[] = { 0x02A00293, 0x00500893, 0x00000073 };
+    const uint32_t fault[] = { 0x80000337, 0x00032383, 0x00A00893, 0x00000073 };
+    const sim_engine_t engines[] = { SIM_ENGINE_SOFT, SIM_ENGINE_THREADED, SIM_ENGINE_BLOCK, SIM_ENGINE_JIT, SIM_ENGINE_TIERED };
+    const char manifest[] = BATCH_TEST_PROGRAM " " BATCH_TEST_OUTPUT " " BATCH_TEST_PASS "\n"
+                            BATCH_TEST_PROGRAM "\n"
+                            BATCH_TEST_FAULT " " BATCH_TEST_FAULT_OUTPUT "\n";
+    int32_t regFile[SIM_REG_COUNT] = {};
+    batch_options_t options = testOptions;
+    batch_t batch;
+
+    writeFile(BATCH_TEST_PROGRAM, program, sizeof(program));
+    writeFile(BATCH_TEST_FAULT, fault, sizeof(fault));
+    regFile[5]  = 42;
+    regFile[17] = 5;
+    writeFile(BATCH_TEST_PASS, regFile, BATCH_REG_FILE_BYTES);
+    writeFile(BATCH_TEST_MANIFEST, manifest, sizeof(manifest) - 1);
+    ASSERT_TRUE(batchReadManifest(BATCH_TEST_MANIFEST, &batch));
+    for (sim_engine_t engine : engines)
+    {
+        options.engine = engine;
+        unlink(BATCH_TEST_OUTPUT);
+        ASSERT_TRUE(batchRun(&batch, &options));
+        EXPECT_EQ(batch.jobs[0].status, BATCH_PASS) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[0].simResult, -1) << simEngineName(engine);
+        EXPECT_EQ(access(BATCH_TEST_OUTPUT, F_OK), 0) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[1].status, BATCH_ERROR) << simEngineName(engine);
+        EXPECT_EQ(batch.jobs[2].status, BATCH_ERROR) << simEngineName(engine);
+        EXPECT_NE(access(BATCH_TEST_FAULT_OUTPUT, F_OK), 0) << simEngineName(engine);
+    }
+
+    batchFree(&batch);
+}
+
+// Every job runs exactly once however the workers split and steal them
+TEST_F(batch, RunManyWorkers)
+{
+    batch_options_t options = testOptions;
+    batch_t batch;
+    char manifest[64 * sizeof(BATCH_TEST_PROGRAM " - " BATCH_TEST_PASS "\n")] = "";
+
+    writeProgram();
+    for (int i = 0; i < 64; i++)
+    {
+        strcat(manifest, BATCH_TEST_PROGRAM " - " BATCH_TEST_PASS "\n");
+    }
+    writeFile(BATCH_TEST_MANIFEST, manifest, strlen(manifest));
+    options.threads = 16;
+    ASSERT_TRUE(batchReadManifest(BATCH_TEST_MANIFEST, &batch));
+    ASSERT_TRUE(batchRun(&batch, &options));
+    EXPECT_EQ(batch.threads, 16u);
+    for (uint32_t i = 0; i < batch.count; i++)
+    {
+        EXPECT_EQ(batch.jobs[i].status, BATCH_PASS) << i;
+        EXPECT_EQ(batch.jobs[i].slices, 1u) << i;
+    }
+
+    batchFree(&batch);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <stdint.h>
+#include <unistd.h> // Supplies optind
 extern "C" {
     #include <cli.h>
 }
@@ -160,3 +161,261 @@ TEST(cli, NoInputOption)
 
     EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_USAGE);
 }
+
+// Select execution engine
+TEST(cli, Engine)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-i";
+    char arg2[] = "inTest.bin";
+    char arg3[] = "-e";
+    char arg4[] = "threaded";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_SUCCESS);
+    EXPECT_STREQ(cliOptions.engineName, arg4);
+    EXPECT_EQ(cliOptions.stats, false);
+}
+
+// Default engine and statistics
+TEST(cli, Stats)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-s";
+    char arg2[] = "-i";
+    char arg3[] = "inTest.bin";
+    char* argv[] = {arg0, arg1, arg2, arg3};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_SUCCESS);
+    EXPECT_EQ(cliOptions.engineName, nullptr);
+    EXPECT_EQ(cliOptions.stats, true);
+}
+
+TEST(cli, Trace)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-i";
+    char arg2[] = "inTest.bin";
+    char arg3[] = "-t";
+    char arg4[] = "trace.bin";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_SUCCESS);
+    EXPECT_STREQ(cliOptions.traceFileName, arg4);
+    EXPECT_STREQ(cliOptions.inFileName, arg2);
+}
+
+TEST(cli, MemorySize)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-i";
+    char arg2[] = "inTest.bin";
+    char arg3[] = "-m";
+    char arg4[] = "4G";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_SUCCESS);
+    EXPECT_EQ(cliOptions.memSize, 1ULL << 32);
+}
+
+TEST(cli, MemorySizeDefault)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-i";
+    char arg2[] = "inTest.bin";
+    char* argv[] = {arg0, arg1, arg2};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_SUCCESS);
+    EXPECT_EQ(cliOptions.memSize, 0u);
+}
+
+// Sizes above the 32-bit address space are rejected
+TEST(cli, MemorySizeTooLarge)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-i";
+    char arg2[] = "inTest.bin";
+    char arg3[] = "-m";
+    char arg4[] = "4097M";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_UNKNOWN_ARG);
+}
+
+TEST(cli, MemorySizeInvalid)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-i";
+    char arg2[] = "inTest.bin";
+    char arg3[] = "-m";
+    char arg4[] = "64KB";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_UNKNOWN_ARG);
+}
+
+TEST(cli, FormatLoadAddressEntry)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-i";
+    char arg2[] = "inTest.hex";
+    char arg3[] = "-f";
+    char arg4[] = "ihex";
+    char arg5[] = "-l";
+    char arg6[] = "0x80000000";
+    char arg7[] = "-p";
+    char arg8[] = "0100";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_SUCCESS);
+    EXPECT_STREQ(cliOptions.formatName, arg4);
+    EXPECT_EQ(cliOptions.loadAddress, 0x80000000u);
+    EXPECT_TRUE(cliOptions.hasEntry);
+    EXPECT_EQ(cliOptions.entry, 100u);  // Decimal despite the leading 0
+}
+
+TEST(cli, EntryDefault)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-i";
+    char arg2[] = "inTest.bin";
+    char* argv[] = {arg0, arg1, arg2};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_SUCCESS);
+    EXPECT_EQ(cliOptions.formatName, nullptr);
+    EXPECT_EQ(cliOptions.loadAddress, 0u);
+    EXPECT_FALSE(cliOptions.hasEntry);
+}
+
+// Addresses beyond 32 bits, signed, with a suffix or without digits are rejected
+TEST(cli, AddressInvalid)
+{
+    const char* invalid[] = {"0x100000000", "-4", "0x", "0x-4", "4K"};
+
+    for (const char* address : invalid)
+    {
+        cli_options_t cliOptions = {0, NULL, NULL};
+        char arg0[] = "RiVIS";
+        char arg1[] = "-i";
+        char arg2[] = "inTest.bin";
+        char arg3[] = "-l";
+        char* argv[] = {arg0, arg1, arg2, arg3, (char*) address};
+        int argc = sizeof(argv)/sizeof(char*);
+
+        optind = 1; // Restart getopt for every parse within the test
+        EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_UNKNOWN_ARG) << address;
+    }
+}
+
+TEST(cli, SnapshotRestore)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "--restore";
+    char arg2[] = "in.snap";
+    char arg3[] = "--snapshot-at";
+    char arg4[] = "1000000";
+    char arg5[] = "--snapshot-file";
+    char arg6[] = "out.snap";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4, arg5, arg6};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_SUCCESS);    // No -i needed when restoring
+    EXPECT_STREQ(cliOptions.restoreFileName, arg2);
+    EXPECT_EQ(cliOptions.snapshotAt, 1000000u);
+    EXPECT_STREQ(cliOptions.snapshotFileName, arg6);
+}
+
+TEST(cli, SnapshotAtInvalid)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-i";
+    char arg2[] = "inTest.bin";
+    char arg3[] = "--snapshot-at";
+    char arg4[] = "0";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_UNKNOWN_ARG);
+}
+
+TEST(cli, SnapshotEvery)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-i";
+    char arg2[] = "inTest.bin";
+    char arg3[] = "--snapshot-every";
+    char arg4[] = "5000";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_SUCCESS);
+    EXPECT_EQ(cliOptions.snapshotEvery, 5000u);
+    EXPECT_EQ(cliOptions.snapshotAt, 0u);
+}
+
+TEST(cli, Batch)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-b";
+    char arg2[] = "jobs.txt";
+    char arg3[] = "-j";
+    char arg4[] = "8";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_SUCCESS);
+    EXPECT_STREQ(cliOptions.batchFileName, "jobs.txt");
+    EXPECT_EQ(cliOptions.threads, 8u);
+    EXPECT_EQ(cliOptions.inFileName, nullptr);
+}
+
+TEST(cli, BatchInvalidThreads)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-b";
+    char arg2[] = "jobs.txt";
+    char arg3[] = "-j";
+    char arg4[] = "many";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_UNKNOWN_ARG);
+}
+
+TEST(cli, BatchSlice)
+{
+    cli_options_t cliOptions = {0, NULL, NULL};
+    char arg0[] = "RiVIS";
+    char arg1[] = "-b";
+    char arg2[] = "jobs.txt";
+    char arg3[] = "--slice";
+    char arg4[] = "1000000";
+    char* argv[] = {arg0, arg1, arg2, arg3, arg4};
+    int argc = sizeof(argv)/sizeof(char*);
+
+    EXPECT_EQ(cliProcessInputs(argc, argv, &cliOptions), CLI_SUCCESS);
+    EXPECT_EQ(cliOptions.slice, 1000000u);
+}
@@ -1,6 +1,12 @@
 #include <gtest/gtest.h>
 #include "fff.h"
 #include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <elf.h>
+#include <vector>
 
 DEFINE_FFF_GLOBALS;
 
@@ -286,3 +292,409 @@ TEST(fileutils, ReadBinarySuccess)
     EXPECT_EQ(memRet, dynMem);
     EXPECT_EQ(fclose_fake.call_count, 1);
 }
+
+/********************************************************************
+ *********************** fileutilsLoadBinary ************************
+ ********************************************************************/
+
+// LoadBinary fopen fails
+TEST(fileutils, LoadBinaryFileOpenFails)
+{
+    RESET_FAKE(fclose);
+    RESET_FAKE(fread);
+
+    uint8_t mem[20];
+
+    fopen_fake.return_val = NULL;       // Mock fopen NULL, FAILURE
+
+    EXPECT_EQ(fileutilsLoadBinary("testin.bin", mem, sizeof(mem)), -1);
+    EXPECT_EQ(fread_fake.call_count, 0);
+    EXPECT_EQ(fclose_fake.call_count, 0);
+}
+
+// LoadBinary file larger than the given memory
+TEST(fileutils, LoadBinaryFileLargerThanMemory)
+{
+    RESET_FAKE(fclose);
+    RESET_FAKE(fread);
+    RESET_FAKE(calloc);
+
+    uint8_t mem[20];
+    FILE file;
+
+    fopen_fake.return_val = &file;              // Mock fopen FILE ptr, success
+    fseek_fake.return_val = 0;                  // Mock fseek 0, success
+    ftell_fake.return_val = sizeof(mem) + 1;    // Mock ftell one byte more than mem
+
+    EXPECT_EQ(fileutilsLoadBinary("testin.bin", mem, sizeof(mem)), -1);
+    EXPECT_EQ(fread_fake.call_count, 0);
+    EXPECT_EQ(fclose_fake.call_count, 1);
+    EXPECT_EQ(calloc_fake.call_count, 0);       // Memory is given, never allocated
+}
+
+// LoadBinary success
+TEST(fileutils, LoadBinarySuccess)
+{
+    RESET_FAKE(fclose);
+    RESET_FAKE(fread);
+
+    int32_t fileSize = 10;
+    uint8_t mem[20];
+    FILE file;
+
+    fopen_fake.return_val = &file;      // Mock fopen FILE ptr, success
+    fseek_fake.return_val = 0;          // Mock fseek 0, success
+    ftell_fake.return_val = fileSize;   // Mock ftell filseSize, success
+    fread_fake.return_val = fileSize;   // Mock fread filseSize, success
+    fclose_fake.return_val = 0;         // Mock fclose 0, success
+
+    EXPECT_EQ(fileutilsLoadBinary("testin.bin", mem, sizeof(mem)), fileSize);
+    EXPECT_EQ(fread_fake.arg0_val, mem);
+    EXPECT_EQ(fclose_fake.call_count, 1);
+}
+
+/********************************************************************
+ *********************** fileutilsMapBinary *************************
+ ********************************************************************/
+/* Mapping needs a real file and page aligned memory, so these tests make them with the not mocked POSIX calls */
+
+// Creates a temporary file holding size bytes of data, and returns its name
+static std::string makeTempFile(const uint8_t* data, size_t size)
+{
+    char name[] = "/tmp/test_fileutils_XXXXXX";
+    int fd = mkstemp(name);
+
+    EXPECT_GE(fd, 0);
+    EXPECT_EQ(write(fd, data, size), (ssize_t) size);
+    close(fd);
+    return name;
+}
+
+// MapBinary open fails
+TEST(fileutils, MapBinaryFileOpenFails)
+{
+    RESET_FAKE(fopen);
+
+    uint8_t mem[20];
+
+    EXPECT_EQ(fileutilsMapBinary("/nonexistent/testin.bin", mem, sizeof(mem)), -1);
+    EXPECT_EQ(fopen_fake.call_count, 0);
+}
+
+// MapBinary file larger than the given memory
+TEST(fileutils, MapBinaryFileLargerThanMemory)
+{
+    const uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    std::string fileName = makeTempFile(data, sizeof(data));
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    uint8_t* mem = (uint8_t*) mmap(NULL, pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    EXPECT_EQ(fileutilsMapBinary(fileName.c_str(), mem, sizeof(data) - 1), -1);
+
+    munmap(mem, pageSize);
+    unlink(fileName.c_str());
+}
+
+// MapBinary of what is not a regular file is streamed, here finding it empty
+TEST(fileutils, MapBinaryNotRegularFile)
+{
+    RESET_FAKE(fopen);
+
+    uint8_t mem[20];
+
+    EXPECT_EQ(fileutilsMapBinary("/dev/null", mem, sizeof(mem)), -1);
+    EXPECT_EQ(fopen_fake.call_count, 0);
+}
+
+// MapBinary success, stores are private to the memory
+TEST(fileutils, MapBinarySuccess)
+{
+    RESET_FAKE(fopen);
+
+    const uint8_t data[10] = {0x13, 0x05, 0xa0, 0x02, 0x73, 0x00, 0x00, 0x00, 0xff, 0x80};
+    uint8_t fileData[sizeof(data)];
+    std::string fileName = makeTempFile(data, sizeof(data));
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    uint8_t* mem = (uint8_t*) mmap(NULL, 2*pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    int fd;
+
+    memset(mem, 0x55, 2*pageSize);
+    EXPECT_EQ(fileutilsMapBinary(fileName.c_str(), mem, 2*pageSize), (int32_t) sizeof(data));
+    EXPECT_EQ(fopen_fake.call_count, 0);
+    EXPECT_EQ(memcmp(mem, data, sizeof(data)), 0);
+    EXPECT_EQ(mem[sizeof(data)], 0);        // Zero past the file end
+    EXPECT_EQ(mem[pageSize], 0x55);         // Beyond the mapped page untouched
+
+    mem[0] = 0;
+    fd = open(fileName.c_str(), O_RDONLY);
+    EXPECT_EQ(read(fd, fileData, sizeof(fileData)), (ssize_t) sizeof(fileData));
+    EXPECT_EQ(memcmp(fileData, data, sizeof(data)), 0);
+    close(fd);
+
+    munmap(mem, 2*pageSize);
+    unlink(fileName.c_str());
+}
+
+/********************************************************************
+ *********************** fileutilsStreamBinary **********************
+ ********************************************************************/
+
+// Returns the read end of a pipe holding size bytes of data and then end of file
+static int makePipe(const uint8_t* data, size_t size)
+{
+    int fds[2];
+
+    EXPECT_EQ(pipe(fds), 0);
+    EXPECT_EQ(write(fds[1], data, size), (ssize_t) size);
+    close(fds[1]);
+    return fds[0];
+}
+
+// StreamBinary of empty input
+TEST(fileutils, StreamBinaryEmpty)
+{
+    uint8_t mem[20];
+    int fd = makePipe(NULL, 0);
+
+    EXPECT_EQ(fileutilsStreamBinary(fd, mem, sizeof(mem)), -1);
+    close(fd);
+}
+
+// StreamBinary of input larger than memory, which is not written past its end
+TEST(fileutils, StreamBinaryLargerThanMemory)
+{
+    const uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t mem[8] = {};
+    int fd = makePipe(data, sizeof(data));
+
+    EXPECT_EQ(fileutilsStreamBinary(fd, mem, sizeof(mem) - 1), -1);
+    EXPECT_EQ(mem[sizeof(mem) - 1], 0);
+    close(fd);
+}
+
+// StreamBinary of input filling memory exactly
+TEST(fileutils, StreamBinarySuccess)
+{
+    const uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t mem[8] = {};
+    int fd = makePipe(data, sizeof(data));
+
+    EXPECT_EQ(fileutilsStreamBinary(fd, mem, sizeof(mem)), (int32_t) sizeof(data));
+    EXPECT_EQ(memcmp(mem, data, sizeof(data)), 0);
+    close(fd);
+}
+
+/********************************************************************
+ *********************** fileutilsLoadElf ***************************
+ ********************************************************************/
+
+/* ELF executable with a text segment of a page and 16 B mapped from a page aligned file offset, and a data segment of
+   8 B followed by 56 B of .bss at an address not congruent to its file offset, so it is copied. */
+class fileutilsElf : public ::testing::Test
+{
+protected:
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    size_t memSize  = 8 * pageSize;
+    std::vector<uint8_t> image = std::vector<uint8_t>(3 * pageSize);
+    Elf32_Ehdr* header   = (Elf32_Ehdr*) image.data();
+    Elf32_Phdr* segments = (Elf32_Phdr*) (image.data() + sizeof(Elf32_Ehdr));
+    uint8_t* mem = NULL;
+    std::string fileName;
+
+    void SetUp() override
+    {
+        memcpy(header->e_ident, ELFMAG, SELFMAG);
+        header->e_ident[EI_CLASS] = ELFCLASS32;
+        header->e_ident[EI_DATA]  = ELFDATA2LSB;
+        header->e_type      = ET_EXEC;
+        header->e_machine   = EM_RISCV;
+        header->e_entry     = pageSize + 4;
+        header->e_phoff     = sizeof(Elf32_Ehdr);
+        header->e_phentsize = sizeof(Elf32_Phdr);
+        header->e_phnum     = 2;
+        segments[0] = { PT_LOAD, (Elf32_Off) pageSize, (Elf32_Addr) pageSize, 0, (Elf32_Word) pageSize + 16, (Elf32_Word) pageSize + 16, PF_R | PF_X, 4 };
+        segments[1] = { PT_LOAD, (Elf32_Off) (2 * pageSize + 0x100), (Elf32_Addr) (3 * pageSize + 8), 0, 8, 64, PF_R | PF_W, 4 };
+        for (size_t i = pageSize; i < image.size(); i++)
+        {
+            image[i] = (uint8_t) (i * 7 + 1);
+        }
+        mem = (uint8_t*) mmap(NULL, memSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+
+    void TearDown() override
+    {
+        munmap(mem, memSize);
+        unlink(fileName.c_str());
+    }
+};
+
+// LoadElf places segments, leaves .bss zero and returns the entry point
+TEST_F(fileutilsElf, LoadSuccess)
+{
+    uint32_t entry = 0;
+    uint8_t fileByte;
+    int fd;
+
+    fileName = makeTempFile(image.data(), image.size());
+    EXPECT_TRUE(fileutilsIsElf(fileName.c_str()));
+    ASSERT_TRUE(fileutilsLoadElf(fileName.c_str(), mem, memSize, &entry));
+    EXPECT_EQ(entry, pageSize + 4);
+    EXPECT_EQ(memcmp(mem + pageSize, image.data() + pageSize, pageSize + 16), 0);
+    EXPECT_EQ(mem[2 * pageSize + 16], 0);                       // Past the text segment
+    EXPECT_EQ(memcmp(mem + 3 * pageSize + 8, image.data() + 2 * pageSize + 0x100, 8), 0);
+    for (size_t i = 3 * pageSize + 16; i < 3 * pageSize + 72; i++)
+    {
+        EXPECT_EQ(mem[i], 0);                                   // .bss
+    }
+
+    mem[pageSize] = ~image[pageSize];                           // Stores stay private
+    fd = open(fileName.c_str(), O_RDONLY);
+    EXPECT_EQ(pread(fd, &fileByte, 1, pageSize), 1);
+    EXPECT_EQ(fileByte, image[pageSize]);
+    close(fd);
+}
+
+// LoadElf rejects executables for other machines
+TEST_F(fileutilsElf, LoadWrongMachine)
+{
+    uint32_t entry = 0;
+
+    header->e_machine = EM_X86_64;
+    fileName = makeTempFile(image.data(), image.size());
+    EXPECT_FALSE(fileutilsLoadElf(fileName.c_str(), mem, memSize, &entry));
+    EXPECT_EQ(entry, 0);
+}
+
+// LoadElf rejects segments reaching beyond memory
+TEST_F(fileutilsElf, LoadSegmentBeyondMemory)
+{
+    uint32_t entry = 0;
+
+    fileName = makeTempFile(image.data(), image.size());
+    EXPECT_FALSE(fileutilsLoadElf(fileName.c_str(), mem, 3 * pageSize + 71, &entry));
+    EXPECT_EQ(entry, 0);
+}
+
+// IsElf is false for flat binaries and standard input
+TEST_F(fileutilsElf, IsElfFlatBinary)
+{
+    fileName = makeTempFile(image.data() + pageSize, 16);
+    EXPECT_FALSE(fileutilsIsElf(fileName.c_str()));
+    EXPECT_FALSE(fileutilsIsElf(FILEUTILS_STDIN_NAME));
+}
+
+/********************************************************************
+ ******************** fileutils hex image loaders *******************
+ ********************************************************************/
+
+// Page aligned memory that hex images and flat binaries are loaded into
+class fileutilsImage : public ::testing::Test
+{
+protected:
+    size_t memSize = 4 * (size_t) sysconf(_SC_PAGESIZE);
+    uint8_t* mem = NULL;
+    std::string fileName;
+
+    void SetUp() override
+    {
+        mem = (uint8_t*) mmap(NULL, memSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+
+    void TearDown() override
+    {
+        munmap(mem, memSize);
+        unlink(fileName.c_str());
+    }
+
+    void makeFile(const char* text)
+    {
+        unlink(fileName.c_str());
+        fileName = makeTempFile((const uint8_t*) text, strlen(text));
+    }
+};
+
+// Intel HEX data records are placed at the load address plus their extended linear address, and the start record
+// gives the entry point
+TEST_F(fileutilsImage, IntelHexSuccess)
+{
+    uint32_t entry = 0;
+    const uint8_t expected[] = {0x13, 0x05, 0xa0, 0x02, 0x73, 0x00, 0x10, 0x00};
+
+    makeFile(":020000040000FA\r\n"
+             ":081000001305A00273001000AB\r\n"
+             ":0400000500001004E3\r\n"
+             ":00000001FF\r\n");
+    ASSERT_TRUE(fileutilsLoadIntelHex(fileName.c_str(), mem, memSize, 0x10, &entry));
+    EXPECT_EQ(memcmp(mem + 0x1010, expected, sizeof(expected)), 0);
+    EXPECT_EQ(entry, 0x1004u);
+}
+
+TEST_F(fileutilsImage, IntelHexBadChecksum)
+{
+    uint32_t entry = 0;
+
+    makeFile(":081000001305A00273001000AD\n:00000001FF\n");
+    EXPECT_FALSE(fileutilsLoadIntelHex(fileName.c_str(), mem, memSize, 0, &entry));
+    EXPECT_EQ(mem[0x1000], 0u);     // Data of a record that fails its checksum is not stored
+}
+
+// Extended address records hold 2 bytes and start records 4, any other length is rejected
+TEST_F(fileutilsImage, IntelHexBadRecordLength)
+{
+    const char* records[] = { ":03000004000000F9\n:00000001FF\n", ":0400000200000000FA\n:00000001FF\n",
+                              ":020000050000F9\n:00000001FF\n", ":06000003000000000000F7\n:00000001FF\n" };
+    uint32_t entry = 0;
+
+    for (const char* record : records)
+    {
+        makeFile(record);
+        EXPECT_FALSE(fileutilsLoadIntelHex(fileName.c_str(), mem, memSize, 0, &entry)) << record;
+    }
+    EXPECT_EQ(entry, 0u);
+}
+
+TEST_F(fileutilsImage, IntelHexBeyondMemory)
+{
+    uint32_t entry = 0;
+
+    makeFile(":020000040001F9\n:081000001305A00273001000AB\n:00000001FF\n");
+    EXPECT_FALSE(fileutilsLoadIntelHex(fileName.c_str(), mem, memSize, 0, &entry));
+}
+
+// $readmemh words are stored little endian, with comments, underscores and word addresses
+TEST_F(fileutilsImage, MemHexSuccess)
+{
+    const uint8_t expected[] = {0x13, 0x05, 0xa0, 0x02, 0x73, 0x00, 0x00, 0x00};
+
+    makeFile("// Program\n"
+             "@00000004 02a0_0513 /* li a0, 42\n   ecall */ 73\n");
+    ASSERT_TRUE(fileutilsLoadMemHex(fileName.c_str(), mem, memSize, 0x100, 4));
+    EXPECT_EQ(memcmp(mem + 0x110, expected, sizeof(expected)), 0);
+
+    makeFile("13 05\n@10 ff\n");
+    ASSERT_TRUE(fileutilsLoadMemHex(fileName.c_str(), mem, memSize, 0, 1));
+    EXPECT_EQ(mem[0], 0x13);
+    EXPECT_EQ(mem[1], 0x05);
+    EXPECT_EQ(mem[0x10], 0xff);
+}
+
+TEST_F(fileutilsImage, MemHexWordTooWide)
+{
+    makeFile("1234\n");
+    EXPECT_FALSE(fileutilsLoadMemHex(fileName.c_str(), mem, memSize, 0, 1));
+    makeFile("12x4\n");
+    EXPECT_FALSE(fileutilsLoadMemHex(fileName.c_str(), mem, memSize, 0, 4));
+}
+
+// LoadProgram places a flat binary at the load address, which is also the entry point
+TEST_F(fileutilsImage, LoadProgramRawAtLoadAddress)
+{
+    uint32_t entry = 0;
+
+    makeFile("RiVIS");
+    ASSERT_TRUE(fileutilsLoadProgram(fileName.c_str(), fileutilsFormatFromName("raw"), mem, memSize, 0x104, &entry));
+    EXPECT_EQ(memcmp(mem + 0x104, "RiVIS", 5), 0);
+    EXPECT_EQ(entry, 0x104u);
+    EXPECT_FALSE(fileutilsLoadProgram(fileName.c_str(), FILEUTILS_FORMAT_RAW, mem, memSize, memSize, &entry));
+    EXPECT_EQ(fileutilsFormatFromName("hex"), FILEUTILS_FORMAT_UNKNOWN);
+}
@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <signal.h>
+#include <string.h>
+extern "C" {
+    #include <guestMem.h>
+}
+
+TEST(guestMem, InvalidSize)
+{
+    guest_mem_t mem = {};
+
+    EXPECT_FALSE(guestMemCreate(&mem, 0));
+    EXPECT_FALSE(guestMemCreate(&mem, GUEST_MEM_SPACE_BYTES + 1));
+}
+
+// Sizes are rounded up to whole pages, which read as zero and are writable to the end
+TEST(guestMem, RoundedToPages)
+{
+    guest_mem_t mem = {};
+    uint64_t pageSize = (uint64_t) sysconf(_SC_PAGESIZE);
+
+    ASSERT_TRUE(guestMemCreate(&mem, 100));
+    EXPECT_EQ(mem.size, pageSize);
+    EXPECT_EQ(mem.base[0], 0);
+    EXPECT_EQ(mem.base[mem.size - 1], 0);
+    mem.base[mem.size - 1] = 0xab;
+    EXPECT_EQ(mem.base[mem.size - 1], 0xab);
+    guestMemDestroy(&mem);
+    EXPECT_EQ(mem.base, nullptr);
+}
+
+// The full address space can be used without committing it, top and bottom pages are both accessible
+TEST(guestMem, FullAddressSpace)
+{
+    guest_mem_t mem = {};
+
+    ASSERT_TRUE(guestMemCreate(&mem, GUEST_MEM_SPACE_BYTES));
+    EXPECT_EQ(mem.size, GUEST_MEM_SPACE_BYTES);
+    mem.base[0] = 1;
+    mem.base[UINT32_MAX] = 2;
+    EXPECT_EQ(mem.base[0], 1);
+    EXPECT_EQ(mem.base[UINT32_MAX], 2);
+    EXPECT_EQ(mem.base[UINT32_MAX / 2], 0);
+    guestMemDestroy(&mem);
+}
+
+TEST(guestMem, Shadow)
+{
+    size_t size = (size_t) 16 << 30;    // Larger than the host is expected to commit
+    uint8_t* shadow = (uint8_t*) guestMemShadowCreate(size);
+
+    ASSERT_NE(shadow, nullptr);
+    EXPECT_EQ(shadow[size - 1], 0);
+    shadow[size / 2] = 1;
+    EXPECT_EQ(shadow[size / 2], 1);
+    guestMemShadowDestroy(shadow, size);
+}
+
+// Accesses beyond the accessible size are caught with their guest address
+TEST(guestMem, FaultBeyondSize)
+{
+    guest_mem_t mem = {};
+    guest_mem_fault_t fault;
+    volatile bool faulted = false;
+
+    ASSERT_TRUE(guestMemCreate(&mem, 100));
+    guestMemArm(&fault, mem.base);
+    if (sigsetjmp(fault.env, 1) != 0)
+    {
+        faulted = true;
+    }
+    else
+    {
+        ((volatile uint8_t*) mem.base)[mem.size + 8] = 1;
+    }
+    guestMemDisarm();
+
+    EXPECT_TRUE(faulted);
+    EXPECT_EQ(fault.adr, mem.size + 8);
+    guestMemDestroy(&mem);
+}
+
+// An access straddling the end of the address space hits the guard region and is reported at the wrapped address
+TEST(guestMem, FaultInGuard)
+{
+    guest_mem_t mem = {};
+    guest_mem_fault_t fault;
+    volatile bool faulted = false;
+
+    ASSERT_TRUE(guestMemCreate(&mem, GUEST_MEM_SPACE_BYTES));
+    guestMemArm(&fault, mem.base);
+    if (sigsetjmp(fault.env, 1) != 0)
+    {
+        faulted = true;
+    }
+    else
+    {
+        (void) ((volatile uint8_t*) mem.base)[GUEST_MEM_SPACE_BYTES + 1];
+    }
+    guestMemDisarm();
+
+    EXPECT_TRUE(faulted);
+    EXPECT_EQ(fault.adr, 1u);
+    guestMemDestroy(&mem);
+}
+
+// Faults outside guest memory keep their default action
+TEST(guestMem, FaultOutsideGuestMemory)
+{
+    guest_mem_t mem = {};
+    guest_mem_fault_t fault;
+
+    ASSERT_TRUE(guestMemCreate(&mem, 100));
+    EXPECT_EXIT({
+        guestMemArm(&fault, mem.base);
+        if (sigsetjmp(fault.env, 1) == 0)
+        {
+            *(volatile uint8_t*) nullptr = 1;
+        }
+        exit(0);
+    }, testing::KilledBySignal(SIGSEGV), "");
+    guestMemDestroy(&mem);
+}
+
+// Only pages written after tracking started are dirty, and writes to clean pages go through
+TEST(guestMem, TrackDirtyPages)
+{
+    guest_mem_t mem = {};
+    uint64_t pageSize = (uint64_t) sysconf(_SC_PAGESIZE);
+
+    ASSERT_TRUE(guestMemCreate(&mem, 16 * pageSize));
+    mem.base[0] = 1;
+    ASSERT_TRUE(guestMemTrack(&mem));
+    EXPECT_FALSE(guestMemIsDirty(&mem, 0));
+    EXPECT_EQ(mem.base[0], 1);                          // Reads do not dirty
+    EXPECT_FALSE(guestMemIsDirty(&mem, 0));
+
+    mem.base[3 * pageSize + 5] = 2;
+    mem.base[3 * pageSize + 6] = 3;
+    mem.base[mem.size - 1] = 4;
+    EXPECT_EQ(mem.base[3 * pageSize + 5], 2);
+    EXPECT_EQ(mem.base[3 * pageSize + 6], 3);
+    EXPECT_EQ(mem.base[mem.size - 1], 4);
+    for (uint64_t page = 0; page < 16; page++)
+    {
+        EXPECT_EQ(guestMemIsDirty(&mem, page * pageSize), page == 3 || page == 15) << "page " << page;
+    }
+    EXPECT_FALSE(guestMemIsDirty(&mem, mem.size));
+
+    guestMemClean(&mem);
+    EXPECT_FALSE(guestMemIsDirty(&mem, 3 * pageSize));
+    mem.base[3 * pageSize] = 5;
+    EXPECT_TRUE(guestMemIsDirty(&mem, 3 * pageSize));
+
+    guestMemUntrack(&mem);
+    EXPECT_EQ(mem.dirty, nullptr);
+    mem.base[0] = 6;
+    EXPECT_EQ(mem.base[0], 6);
+    guestMemDestroy(&mem);
+}
+
+// Reset copies back the dirty pages only, clean pages are not read from the image
+TEST(guestMem, ResetFromImage)
+{
+    guest_mem_t mem = {};
+    guest_mem_t image = {};
+    uint64_t pageSize = (uint64_t) sysconf(_SC_PAGESIZE);
+
+    ASSERT_TRUE(guestMemCreate(&mem, 8 * pageSize));
+    ASSERT_TRUE(guestMemCreate(&image, 8 * pageSize));
+    for (uint64_t i = 0; i < mem.size; i++)
+    {
+        mem.base[i] = image.base[i] = (uint8_t) i;
+    }
+    ASSERT_TRUE(guestMemTrack(&mem));
+    memset(mem.base + pageSize, 0xff, 2 * pageSize);
+    mem.base[7 * pageSize] = 0xff;
+    image.base[5 * pageSize] = 0xee;                    // Not dirty in mem, so not copied
+
+    guestMemReset(&mem, &image);
+    EXPECT_EQ(memcmp(mem.base, image.base, 5 * pageSize), 0);
+    EXPECT_EQ(mem.base[5 * pageSize], 0);
+    EXPECT_EQ(memcmp(mem.base + 6 * pageSize, image.base + 6 * pageSize, 2 * pageSize), 0);
+    for (uint64_t page = 0; page < 8; page++)
+    {
+        EXPECT_FALSE(guestMemIsDirty(&mem, page * pageSize));
+    }
+
+    mem.base[0] = 0xff;                                 // Tracked again after the reset
+    EXPECT_TRUE(guestMemIsDirty(&mem, 0));
+    guestMemDestroy(&mem);
+    guestMemDestroy(&image);
+}
+
+// A tracked memory still reports accesses beyond its size as faults
+TEST(guestMem, TrackedFaultBeyondSize)
+{
+    guest_mem_t mem = {};
+    guest_mem_fault_t fault;
+    volatile bool faulted = false;
+
+    ASSERT_TRUE(guestMemCreate(&mem, 100));
+    ASSERT_TRUE(guestMemTrack(&mem));
+    guestMemArm(&fault, mem.base);
+    if (sigsetjmp(fault.env, 1) != 0)
+    {
+        faulted = true;
+    }
+    else
+    {
+        ((volatile uint8_t*) mem.base)[1] = 1;
+        ((volatile uint8_t*) mem.base)[mem.size] = 1;
+    }
+    guestMemDisarm();
+
+    EXPECT_TRUE(faulted);
+    EXPECT_EQ(fault.adr, mem.size);
+    EXPECT_EQ(mem.base[1], 1);
+    EXPECT_TRUE(guestMemIsDirty(&mem, 0));
+    guestMemDestroy(&mem);
+}
@@ -86,6 +86,46 @@ TEST(rv32i, DecodeInstructionType)
     EXPECT_EQ(rv32iDecodeInstructType(instruct), RV32I_NOT_SUPPORTED);
 }
 
+TEST(rv32i, InstructName)
+{
+    EXPECT_STREQ(rv32iInstructName(RV32I_ADD), "ADD");
+    EXPECT_STREQ(rv32iInstructName(RV32I_SLTIU), "SLTIU");
+    EXPECT_STREQ(rv32iInstructName(RV32I_XORI), "XORI");
+    EXPECT_STREQ(rv32iInstructName(RV32I_NOT_SUPPORTED), "NOT_SUPPORTED");
+    EXPECT_STREQ(rv32iInstructName(RV32I_INSTRUCT_COUNT), "NOT_SUPPORTED");
+}
+
+TEST(rv32i, Decode)
+{
+    rv32i_decoded_t decoded;
+
+    decoded = rv32iDecode(INSTRUCT_ADDI_RD_13_RS1_31_IMM_NEG1);
+    EXPECT_EQ(decoded.type, RV32I_ADDI);
+    EXPECT_EQ(decoded.format, RV32I_OPCODE_TYPE_I);
+    EXPECT_EQ(decoded.rd, 13);
+    EXPECT_EQ(decoded.rs1, 31);
+    EXPECT_EQ(decoded.imm, -1);
+
+    decoded = rv32iDecode(INSTRUCT_BGE_RS1_2_RS2_17_IMM_MIN);
+    EXPECT_EQ(decoded.type, RV32I_BGE);
+    EXPECT_EQ(decoded.format, RV32I_OPCODE_TYPE_B);
+    EXPECT_EQ(decoded.rs1, 2);
+    EXPECT_EQ(decoded.rs2, 17);
+    EXPECT_EQ(decoded.imm, -(0x1000));
+
+    decoded = rv32iDecode(INSTRUCT_SUB_RD_21_RS1_10_RS2_0);
+    EXPECT_EQ(decoded.type, RV32I_SUB);
+    EXPECT_EQ(decoded.format, RV32I_OPCODE_TYPE_R);
+    EXPECT_EQ(decoded.rd, 21);
+    EXPECT_EQ(decoded.rs1, 10);
+    EXPECT_EQ(decoded.rs2, 0);
+
+    // Illegal funct7 for add/sub
+    decoded = rv32iDecode(RV32I_OPCODE_ALU | (0b0000001 << 25));
+    EXPECT_EQ(decoded.type, RV32I_NOT_SUPPORTED);
+    EXPECT_EQ(decoded.format, RV32I_OPCODE_TYPE_UNKNOWN);
+}
+
 /*
 NOTICE: This is by far the most complex logic making it error prone.
 It switches over 5 distict types with different logic. They should all be tested.
@@ -174,6 +214,23 @@ TEST(rv32i, LoadWord)
     EXPECT_EQ(rv32iLoadWord(A+1), (int32_t) 0b10000000'01010101'10101010'00000010);
 }
 
+TEST(rv32i, LoadStoreRoundTripUnaligned)
+{
+    uint8_t A[8] = {};
+    for (int offset = 0; offset < 4; offset++)
+    {
+        rv32iStoreWord(A+offset, 0x80402010);
+        EXPECT_EQ(rv32iLoadWord(A+offset), (int32_t) 0x80402010); // Sign bit kept
+        EXPECT_EQ(A[offset], 0x10);
+        EXPECT_EQ(A[offset+3], 0x80);
+
+        rv32iStoreHalfWord(A+offset, 0x8001);
+        EXPECT_EQ(rv32iLoadHalfWord(A+offset), (int32_t) 0x8001); // Zero extended
+        EXPECT_EQ(A[offset], 0x01);
+        EXPECT_EQ(A[offset+1], 0x80);
+    }
+}
+
 TEST(rv32i, StoreByte)
 {
     uint8_t A[5] = {};
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+extern "C" {
+    #include <snapshot.h>
+}
+
+#define SNAPSHOT_TEST_FILE  "test_snapshot.snap"
+
+static long fileSize(const char* fileName)
+{
+    FILE* file = fopen(fileName, "rb");
+    long size;
+
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+// State and non-zero pages are restored, and only those pages and one header per run of them are stored
+TEST(snapshot, SaveRestore)
+{
+    guest_mem_t mem = {};
+    guest_mem_t restored = {};
+    sim_state_t state = {};
+    sim_state_t restoredState = {};
+
+    ASSERT_TRUE(guestMemCreate(&mem, 1 << 20));
+    for (int i = 0; i < SIM_REG_COUNT; i++)
+    {
+        state.regFile[i] = i * 0x01010101;
+    }
+    state.pc = 0x1234;
+    state.instructCount = 1ULL << 40;
+    mem.base[0] = 1;                                        // Run of pages 0 and 1
+    mem.base[2 * SNAPSHOT_PAGE_BYTES - 1] = 2;
+    mem.base[mem.size - 1] = 3;                             // Last page
+    mem.base[8 * SNAPSHOT_PAGE_BYTES] = 0;                  // Touched but zero
+
+    ASSERT_TRUE(snapshotSave(SNAPSHOT_TEST_FILE, &state, &mem));
+    EXPECT_EQ(fileSize(SNAPSHOT_TEST_FILE), (long) (sizeof(snapshot_file_header_t) + 3 * sizeof(snapshot_run_t) + 3 * SNAPSHOT_PAGE_BYTES));
+
+    restoredState.regFile[SIM_REG_DISCARD] = 42;
+    ASSERT_TRUE(snapshotRestore(SNAPSHOT_TEST_FILE, &restoredState, &restored));
+    EXPECT_EQ(restored.size, mem.size);
+    EXPECT_EQ(memcmp(restored.base, mem.base, mem.size), 0);
+    EXPECT_EQ(memcmp(restoredState.regFile, state.regFile, sizeof(state.regFile)), 0);
+    EXPECT_EQ(restoredState.pc, state.pc);
+    EXPECT_EQ(restoredState.instructCount, state.instructCount);
+
+    guestMemDestroy(&mem);
+    guestMemDestroy(&restored);
+    unlink(SNAPSHOT_TEST_FILE);
+}
+
+TEST(snapshot, RestoreNotSnapshot)
+{
+    guest_mem_t mem = {};
+    sim_state_t state = {};
+    FILE* file = fopen(SNAPSHOT_TEST_FILE, "wb");
+
+    fputs("RiVIS", file);
+    fclose(file);
+    EXPECT_FALSE(snapshotRestore(SNAPSHOT_TEST_FILE, &state, &mem));
+    EXPECT_EQ(mem.base, nullptr);
+    EXPECT_FALSE(snapshotRestore("/nonexistent/test.snap", &state, &mem));
+    unlink(SNAPSHOT_TEST_FILE);
+}
+
+// A snapshot cut short within its pages fails without leaving memory behind
+TEST(snapshot, RestoreTruncated)
+{
+    guest_mem_t mem = {};
+    sim_state_t state = {};
+
+    ASSERT_TRUE(guestMemCreate(&mem, 1 << 20));
+    mem.base[0] = 1;
+    ASSERT_TRUE(snapshotSave(SNAPSHOT_TEST_FILE, &state, &mem));
+    guestMemDestroy(&mem);
+    ASSERT_EQ(truncate(SNAPSHOT_TEST_FILE, fileSize(SNAPSHOT_TEST_FILE) - sizeof(snapshot_run_t) - 1), 0);
+
+    EXPECT_FALSE(snapshotRestore(SNAPSHOT_TEST_FILE, &state, &mem));
+    EXPECT_EQ(mem.base, nullptr);
+    unlink(SNAPSHOT_TEST_FILE);
+}
+
+// Appended checkpoints hold the pages written since the previous one, including pages written to zero, and
+// restoring replays them up to the last state
+TEST(snapshot, AppendIncremental)
+{
+    guest_mem_t mem = {};
+    guest_mem_t restored = {};
+    sim_state_t state = {};
+    sim_state_t restoredState = {};
+    long fullSize;
+
+    ASSERT_TRUE(guestMemCreate(&mem, 1 << 20));
+    EXPECT_FALSE(snapshotAppend(SNAPSHOT_TEST_FILE, &state, &mem));    // Not tracked
+    mem.base[0] = 1;
+    mem.base[4 * SNAPSHOT_PAGE_BYTES] = 4;
+    state.pc = 4;
+    ASSERT_TRUE(snapshotSave(SNAPSHOT_TEST_FILE, &state, &mem));
+    fullSize = fileSize(SNAPSHOT_TEST_FILE);
+
+    ASSERT_TRUE(guestMemTrack(&mem));
+    mem.base[0] = 0;
+    mem.base[2 * SNAPSHOT_PAGE_BYTES] = 2;
+    state.pc = 8;
+    state.instructCount = 2;
+    state.regFile[1] = 1;
+    ASSERT_TRUE(snapshotAppend(SNAPSHOT_TEST_FILE, &state, &mem));
+    EXPECT_FALSE(guestMemIsDirty(&mem, 0));
+    mem.base[2 * SNAPSHOT_PAGE_BYTES] = 3;
+    state.pc = 12;
+    state.instructCount = 3;
+    ASSERT_TRUE(snapshotAppend(SNAPSHOT_TEST_FILE, &state, &mem));
+    EXPECT_EQ(fileSize(SNAPSHOT_TEST_FILE), fullSize + (long) (2 * sizeof(snapshot_file_header_t) + 5 * sizeof(snapshot_run_t) +
+                                                               3 * SNAPSHOT_PAGE_BYTES));
+
+    ASSERT_TRUE(snapshotRestore(SNAPSHOT_TEST_FILE, &restoredState, &restored));
+    EXPECT_EQ(memcmp(restored.base, mem.base, mem.size), 0);
+    EXPECT_EQ(restored.base[0], 0);
+    EXPECT_EQ(restored.base[2 * SNAPSHOT_PAGE_BYTES], 3);
+    EXPECT_EQ(restored.base[4 * SNAPSHOT_PAGE_BYTES], 4);
+    EXPECT_EQ(restoredState.pc, 12u);
+    EXPECT_EQ(restoredState.instructCount, 3u);
+    EXPECT_EQ(restoredState.regFile[1], 1);
+
+    guestMemDestroy(&mem);
+    guestMemDestroy(&restored);
+    unlink(SNAPSHOT_TEST_FILE);
+}
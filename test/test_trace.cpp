@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <string>
+extern "C" {
+    #include <trace.h>
+    #include <flight.h>
+}
+
+static std::vector<trace_record_t> readTrace(const char* fileName, trace_file_header_t* header)
+{
+    std::vector<trace_record_t> records;
+    trace_record_t record;
+    FILE* file = fopen(fileName, "rb");
+
+    EXPECT_NE(file, nullptr);
+    if (file == NULL)
+    {
+        return records;
+    }
+    EXPECT_EQ(fread(header, sizeof(*header), 1, file), 1u);
+    while (fread(&record, sizeof(record), 1, file) == 1)
+    {
+        records.push_back(record);
+    }
+    fclose(file);
+    return records;
+}
+
+static std::string dumpFlight(const flight_recorder_t* recorder)
+{
+    std::string dump;
+    char buffer[256];
+    size_t nBytes;
+    FILE* file = tmpfile();
+
+    EXPECT_NE(file, nullptr);
+    if (file == NULL)
+    {
+        return dump;
+    }
+    flightDump(recorder, fileno(file));
+    rewind(file);
+    while ( (nBytes = fread(buffer, 1, sizeof(buffer), file)) > 0 )
+    {
+        dump.append(buffer, nBytes);
+    }
+    fclose(file);
+    return dump;
+}
+
+TEST(trace, InvalidCapacity)
+{
+    EXPECT_EQ(traceOpen("test_trace_invalid.bin", 0), nullptr);
+    EXPECT_EQ(traceOpen("test_trace_invalid.bin", 2), nullptr);
+    EXPECT_EQ(traceOpen("test_trace_invalid.bin", 100), nullptr);
+}
+
+TEST(trace, Empty)
+{
+    trace_file_header_t header;
+    trace_t* trace = traceOpen("test_trace_empty.bin", 16);
+
+    ASSERT_NE(trace, nullptr);
+    EXPECT_TRUE(traceClose(trace));
+
+    std::vector<trace_record_t> records = readTrace("test_trace_empty.bin", &header);
+    EXPECT_EQ(memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)), 0);
+    EXPECT_EQ(header.version, TRACE_VERSION);
+    EXPECT_EQ(header.recordSize, sizeof(trace_record_t));
+    EXPECT_EQ(records.size(), 0u);
+}
+
+// Many more records than the ring holds, so the producer wraps and waits for the writer
+TEST(trace, Wraparound)
+{
+    const uint32_t nRecords = 100000;
+    trace_file_header_t header;
+    trace_t* trace = traceOpen("test_trace_wraparound.bin", 16);
+
+    ASSERT_NE(trace, nullptr);
+    for (uint32_t i = 0; i < nRecords; i++)
+    {
+        *traceRecord(trace) = (trace_record_t) {
+            .pc       = i * 4,
+            .instruct = i ^ 0xdeadbeef,
+            .rdValue  = (int32_t) -i,
+            .memAdr   = i * 8,
+            .rd       = (uint8_t) (i % 32),
+            .flags    = TRACE_FLAG_WRITE,
+        };
+    }
+    EXPECT_TRUE(traceClose(trace));
+
+    std::vector<trace_record_t> records = readTrace("test_trace_wraparound.bin", &header);
+    ASSERT_EQ(records.size(), nRecords);
+    for (uint32_t i = 0; i < nRecords; i++)
+    {
+        ASSERT_EQ(records[i].pc, i * 4);
+        ASSERT_EQ(records[i].instruct, i ^ 0xdeadbeef);
+        ASSERT_EQ(records[i].rdValue, (int32_t) -i);
+        ASSERT_EQ(records[i].memAdr, i * 8);
+        ASSERT_EQ(records[i].rd, i % 32);
+        ASSERT_EQ(records[i].flags, TRACE_FLAG_WRITE);
+    }
+}
+
+TEST(flight, Empty)
+{
+    flight_recorder_t recorder = {};
+
+    EXPECT_EQ(dumpFlight(&recorder), "Flight recorder: last 0 instructions\n");
+}
+
+TEST(flight, Partial)
+{
+    flight_recorder_t recorder = {};
+
+    flightRecord(&recorder, 1, 0x0, 0x00500093)->rdValue = 5;  // addi x1, x0, 5
+    flightRecord(&recorder, 2, 0x4, 0x00102023);                // sw x1, 0(x0)
+
+    EXPECT_EQ(dumpFlight(&recorder),
+              "Flight recorder: last 2 instructions\n"
+              "  PC = 0x00000000  0x00500093  ADDI  x1 = 0x00000005\n"
+              "  PC = 0x00000004  0x00102023  SW\n");
+}
+
+// More instructions than the ring holds, oldest first
+TEST(flight, Wraparound)
+{
+    flight_recorder_t recorder = {};
+    std::string dump;
+
+    for (uint32_t i = 0; i < 200; i++)
+    {
+        flightRecord(&recorder, i + 1, i * 4, 0x00000013);  // nop
+    }
+    dump = dumpFlight(&recorder);
+
+    EXPECT_EQ(dump.rfind("Flight recorder: last 64 instructions\n", 0), 0u);
+    EXPECT_NE(dump.find("  PC = 0x00000220  0x00000013  ADDI\n"), std::string::npos);     // Oldest, i = 136
+    EXPECT_EQ(dump.find("  PC = 0x0000021c"), std::string::npos);
+    EXPECT_EQ(dump.substr(dump.size() - 36), "  PC = 0x0000031c  0x00000013  ADDI\n");   // Newest, i = 199
+    EXPECT_LT(dump.find("PC = 0x00000220"), dump.find("PC = 0x00000224"));
+}
+
+// The newest instruction of an interrupted run is shown without a register write
+TEST(flight, Interrupted)
+{
+    flight_recorder_t recorder = {};
+
+    flightRecord(&recorder, 1, 0x0, 0x00500093)->rdValue = 5;  // addi x1, x0, 5
+    flightRecord(&recorder, 2, 0x4, 0x0000a103);                // lw x2, 0(x1)
+    recorder.interrupted = true;
+
+    EXPECT_EQ(flightNewest(&recorder), &recorder.records[2]);
+    EXPECT_EQ(dumpFlight(&recorder),
+              "Flight recorder: last 2 instructions\n"
+              "  PC = 0x00000000  0x00500093  ADDI  x1 = 0x00000005\n"
+              "  PC = 0x00000004  0x0000a103  LW  not completed\n");
+}
+
+// Engines recording blocks show the first instruction of each without register writes
+TEST(flight, Blocks)
+{
+    flight_recorder_t recorder = {};
+
+    recorder.blocks = true;
+    flightRecord(&recorder, 1, 0x0, 0x00500093);    // addi x1, x0, 5
+    flightRecord(&recorder, 2, 0x8, 0x0000a103);    // lw x2, 0(x1)
+    recorder.interrupted = true;
+
+    EXPECT_EQ(dumpFlight(&recorder),
+              "Flight recorder: last 2 blocks entered\n"
+              "  PC = 0x00000000  0x00500093  ADDI\n"
+              "  PC = 0x00000008  0x0000a103  LW  not completed\n");
+}